@@ -0,0 +1,74 @@
+#include <string.h>
+#include <stdint.h>
+#include "inverse256.h"
+#include "mont256.h"
+
+extern void (*inverse256_skylake_core)(unsigned char *,const unsigned char *,const int64_t *);
+
+/* Montgomery's trick: invert n elements with one call to the divstep
+   engine and 3(n-1) multiplications.
+
+   The running products c_i = a_1...a_i/2^(256(i-1)) are kept in the
+   Montgomery sense, so u = 1/c_n satisfies 1/a_i = mont(u,c_{i-1}) and
+   1/c_{i-1} = mont(u,a_i) exactly, without converting in or out.
+
+   Zero inputs (mod p) are replaced by 1 before they enter the product
+   and their outputs are cleared afterwards, in constant time, so
+   1/0 = 0 as in the single-element API and the other elements are
+   unaffected.
+
+   out holds the c_i while the products are built, so out and in must
+   not overlap. */
+
+static const uint64_t one[4] = {1,0,0,0};
+
+static uint64_t load(uint64_t *a,const unsigned char *s,const int64_t *table)
+{
+  uint64_t z;
+
+  mont256_load(a,s,table);
+  z = mont256_iszero(a);
+  mont256_cmov(a,one,z);
+  return z;
+}
+
+static void clear(uint64_t *h,uint64_t mask)
+{
+  long long i;
+
+  for (i = 0;i < 4;++i) h[i] &= ~mask;
+}
+
+void inverse256_batch(unsigned char *out,const unsigned char *in,long long n,const int64_t *table)
+{
+  uint64_t a[4],c[4],u[4],r[4];
+  unsigned char s[32];
+  uint64_t z;
+  long long i;
+
+  if (n <= 0) return;
+
+  load(c,in,table);
+  memcpy(out,c,32);
+  for (i = 1;i < n;++i) {
+    load(a,in+32*i,table);
+    mont256_mul(c,c,a,table);
+    memcpy(out+32*i,c,32);
+  }
+
+  mont256_store(s,c);
+  inverse256_skylake_core(s,s,table);
+  mont256_load(u,s,table);
+
+  for (i = n-1;i > 0;--i) {
+    z = load(a,in+32*i,table);
+    memcpy(c,out+32*(i-1),32);
+    mont256_mul(r,u,c,table);
+    mont256_mul(u,u,a,table);
+    clear(r,z);
+    mont256_store(out+32*i,r);
+  }
+  z = load(a,in,table);
+  clear(u,z);
+  mont256_store(out,u);
+}
@@ -0,0 +1,313 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdint.h>
+#include "inverse256.h"
+
+/* Deferred inversion, for code that handles one request at a time and
+   never has an array to give inverse256_batch().  inverse256_ctx_put()
+   queues an element and returns a handle; inverse256_ctx_get() waits
+   for its inverse.  The queued elements are inverted together, up to
+   size of them per call of the batch code, as soon as size are
+   waiting or the oldest has waited deadline nanoseconds, whichever is
+   first; so each caller waits at most about deadline plus one batch.
+
+   The queue is a bounded ring of slots (Vyukov's MPMC queue, used
+   here with many producers and one consumer).  Slot i holds the
+   elements with handle t = i mod R, and its sequence word says where
+   the current one is: t free, t+1 queued, t+2 inverted, t+R collected
+   and free for the next lap.  Producers claim a handle by CAS on tail
+   without locking; the consumer walks head over the run of queued
+   slots.  A mutex and two condition variables are there only to sleep
+   on; the data never goes through them.
+
+   With a worker, a background thread is the consumer: it sleeps until
+   size elements are queued or the deadline of the oldest one.  Without
+   one, the put that completes a batch inverts it, and so do a put
+   and a get that find the oldest queued element past its deadline; a
+   get sleeps until that deadline at the latest.  So the deadline only
+   holds while some caller is in put or get: callers that queue
+   elements and then go off to do other work leave them there until
+   one of them comes back.  In both cases inverse256_ctx_flush()
+   inverts everything queued now.  Either way the bound is on top of
+   scheduling: with more threads than CPUs, a thread that is due can
+   wait for a time slice.
+
+   Every handle must be collected by exactly one get.  The ring has 4
+   slots per batch element (at least 64), and put fails with EAGAIN
+   when the slot it needs has not been collected since the last lap,
+   that is, while the handle R before it is still out: a caller that
+   keeps one handle while others go through R elements blocks them
+   all, and they have to wait for it (or invert without the context). */
+
+typedef struct {
+  long long seq;
+  long long time;
+  unsigned char in[32];
+  unsigned char out[32];
+} __attribute__((aligned(64))) slot;
+
+struct inverse256_ctx {
+  long long tail __attribute__((aligned(64)));
+  long long head __attribute__((aligned(64)));
+  slot *ring;
+  long long mask,size,deadline;
+  const int64_t *table;
+  unsigned char *in,*out;
+  pthread_mutex_t consumer;
+  pthread_mutex_t lock;
+  pthread_cond_t wake,done;
+  pthread_t worker;
+  int threaded,stop;
+} ;
+
+static long long now(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC,&t);
+  return t.tv_sec*1000000000LL+t.tv_nsec;
+}
+
+static void until(struct timespec *t,long long ns)
+{
+  t->tv_sec = ns/1000000000;
+  t->tv_nsec = ns%1000000000;
+}
+
+static void wake(inverse256_ctx *c)
+{
+  pthread_mutex_lock(&c->lock);
+  pthread_cond_broadcast(&c->wake);
+  pthread_mutex_unlock(&c->lock);
+}
+
+/* invert the queued run at head, up to size elements; the caller
+   holds c->consumer */
+
+static long long drain(inverse256_ctx *c)
+{
+  long long h = c->head,n,i;
+  slot *s;
+
+  for (n = 0;n < c->size;++n) {
+    s = &c->ring[(h+n)&c->mask];
+    if (__atomic_load_n(&s->seq,__ATOMIC_ACQUIRE) != h+n+1) break;
+    memcpy(c->in+32*n,s->in,32);
+  }
+  if (!n) return 0;
+
+  inverse256_batch(c->out,c->in,n,c->table);
+  for (i = 0;i < n;++i) {
+    s = &c->ring[(h+i)&c->mask];
+    memcpy(s->out,c->out+32*i,32);
+    __atomic_store_n(&s->seq,h+i+2,__ATOMIC_RELEASE);
+  }
+  __atomic_store_n(&c->head,h+n,__ATOMIC_RELEASE);
+
+  /* the getters, and the worker in case this was a flush from outside
+     that left it looking at a slot already done */
+  pthread_mutex_lock(&c->lock);
+  pthread_cond_broadcast(&c->done);
+  if (c->threaded) pthread_cond_broadcast(&c->wake);
+  pthread_mutex_unlock(&c->lock);
+  return n;
+}
+
+/* when the oldest queued element is due, or s, whichever is first */
+
+static long long due(inverse256_ctx *c,const slot *s)
+{
+  long long h = __atomic_load_n(&c->head,__ATOMIC_ACQUIRE);
+  const slot *o = &c->ring[h&c->mask];
+  long long t = __atomic_load_n(&s->time,__ATOMIC_RELAXED),u;
+
+  if (__atomic_load_n(&o->seq,__ATOMIC_ACQUIRE) == h+1) {
+    u = __atomic_load_n(&o->time,__ATOMIC_RELAXED);
+    if (u < t) t = u;
+  }
+  return t+c->deadline;
+}
+
+void inverse256_ctx_flush(inverse256_ctx *c)
+{
+  pthread_mutex_lock(&c->consumer);
+  while (drain(c) == c->size) ;
+  pthread_mutex_unlock(&c->consumer);
+}
+
+static void *worker(void *arg)
+{
+  inverse256_ctx *c = arg;
+  struct timespec ts;
+  long long h,due;
+  slot *s;
+
+  pthread_mutex_lock(&c->lock);
+  while (!c->stop) {
+    h = __atomic_load_n(&c->head,__ATOMIC_ACQUIRE);
+    s = &c->ring[h&c->mask];
+    /* pairs with the fence in inverse256_ctx_put(): drain() stored head,
+       the put stores seq, and each then loads the other; without both
+       fences each may miss the other's store, and the put does not wake
+       a worker that goes to sleep on an element already queued */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&s->seq,__ATOMIC_ACQUIRE) != h+1) {
+      pthread_cond_wait(&c->wake,&c->lock);
+      continue;
+    }
+    due = __atomic_load_n(&s->time,__ATOMIC_RELAXED)+c->deadline;
+    if (__atomic_load_n(&c->tail,__ATOMIC_RELAXED)-h < c->size && now() < due) {
+      until(&ts,due);
+      pthread_cond_timedwait(&c->wake,&c->lock,&ts);
+      continue;
+    }
+    pthread_mutex_unlock(&c->lock);
+    inverse256_ctx_flush(c);
+    pthread_mutex_lock(&c->lock);
+  }
+  pthread_mutex_unlock(&c->lock);
+  return 0;
+}
+
+long long inverse256_ctx_put(inverse256_ctx *c,const unsigned char *in)
+{
+  long long t = __atomic_load_n(&c->tail,__ATOMIC_RELAXED),seq,h,at;
+  slot *s;
+
+  for (;;) {
+    s = &c->ring[t&c->mask];
+    seq = __atomic_load_n(&s->seq,__ATOMIC_ACQUIRE);
+    if (seq == t) {
+      if (__atomic_compare_exchange_n(&c->tail,&t,t+1,1,__ATOMIC_RELAXED,__ATOMIC_RELAXED)) break;
+    } else if (seq < t) {
+      errno = EAGAIN;
+      return -1;
+    } else
+      t = __atomic_load_n(&c->tail,__ATOMIC_RELAXED);
+  }
+  memcpy(s->in,in,32);
+  at = now();
+  __atomic_store_n(&s->time,at,__ATOMIC_RELAXED);
+  __atomic_store_n(&s->seq,t+1,__ATOMIC_RELEASE);
+  /* store seq before loading head; see worker() */
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+  /* a full batch, or the first element the worker has to time; without
+     it, also an oldest element left past its deadline */
+  h = __atomic_load_n(&c->head,__ATOMIC_ACQUIRE);
+  if (t+1-h >= c->size) {
+    if (c->threaded) wake(c);
+    else inverse256_ctx_flush(c);
+  } else if (c->threaded) {
+    if (t == h) wake(c);
+  } else if (at >= due(c,s) && pthread_mutex_trylock(&c->consumer) == 0) {
+    /* only if no one is inverting already: a put that slept here
+       would let the others run a lap of the ring past handles its
+       caller has yet to collect, and they would all wait on it */
+    while (drain(c) == c->size) ;
+    pthread_mutex_unlock(&c->consumer);
+  }
+  return t;
+}
+
+void inverse256_ctx_get(inverse256_ctx *c,unsigned char *out,long long t)
+{
+  slot *s = &c->ring[t&c->mask];
+  struct timespec ts;
+  long long d;
+
+  while (__atomic_load_n(&s->seq,__ATOMIC_ACQUIRE) != t+2) {
+    d = due(c,s);
+    if (!c->threaded && now() >= d) {
+      inverse256_ctx_flush(c);
+      continue;
+    }
+    pthread_mutex_lock(&c->lock);
+    if (__atomic_load_n(&s->seq,__ATOMIC_ACQUIRE) != t+2) {
+      if (c->threaded)
+        pthread_cond_wait(&c->done,&c->lock);
+      else {
+        until(&ts,d);
+        pthread_cond_timedwait(&c->done,&c->lock,&ts);
+      }
+    }
+    pthread_mutex_unlock(&c->lock);
+  }
+  memcpy(out,s->out,32);
+  __atomic_store_n(&s->seq,t+c->mask+1,__ATOMIC_RELEASE);
+}
+
+void inverse256_ctx_free(inverse256_ctx *c)
+{
+  if (!c) return;
+  if (c->threaded) {
+    pthread_mutex_lock(&c->lock);
+    c->stop = 1;
+    pthread_cond_broadcast(&c->wake);
+    pthread_mutex_unlock(&c->lock);
+    pthread_join(c->worker,0);
+  }
+  pthread_cond_destroy(&c->wake);
+  pthread_cond_destroy(&c->done);
+  pthread_mutex_destroy(&c->lock);
+  pthread_mutex_destroy(&c->consumer);
+  free(c->ring);
+  free(c->in);
+  free(c->out);
+  free(c);
+}
+
+/* 0 with errno set on failure */
+
+inverse256_ctx *inverse256_ctx_new(const int64_t *table,long long size,long long deadline,int threaded)
+{
+  inverse256_ctx *c;
+  pthread_condattr_t attr;
+  long long r = 64,i;
+
+  if (size < 1) size = 1;
+  if (deadline < 0) deadline = 0;
+  while (r < 4*size) r *= 2;
+
+  c = aligned_alloc(64,sizeof *c);
+  if (!c) return 0;
+  memset(c,0,sizeof *c);
+  c->ring = aligned_alloc(64,r*sizeof(slot));
+  c->in = malloc(32*size);
+  c->out = malloc(32*size);
+  if (!c->ring || !c->in || !c->out) {
+    free(c->ring);
+    free(c->in);
+    free(c->out);
+    free(c);
+    errno = ENOMEM;
+    return 0;
+  }
+  for (i = 0;i < r;++i) c->ring[i].seq = i;
+  c->mask = r-1;
+  c->size = size;
+  c->deadline = deadline;
+  c->table = table;
+
+  pthread_mutex_init(&c->consumer,0);
+  pthread_mutex_init(&c->lock,0);
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr,CLOCK_MONOTONIC);
+  pthread_cond_init(&c->wake,&attr);
+  pthread_cond_init(&c->done,&attr);
+  pthread_condattr_destroy(&attr);
+
+  if (threaded) {
+    c->threaded = 1;
+    if (pthread_create(&c->worker,0,worker,c) != 0) {
+      c->threaded = 0;
+      inverse256_ctx_free(c);
+      errno = EAGAIN;
+      return 0;
+    }
+  }
+  return c;
+}
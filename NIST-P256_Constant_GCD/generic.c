@@ -0,0 +1,119 @@
+#include <string.h>
+#include <stdint.h>
+#include "inverse256.h"
+#include "mont256.h"
+
+extern void (*inverse256_skylake_core)(unsigned char *,const unsigned char *,const int64_t *);
+
+/* Builds the 64-entry table described in table.c for an odd modulus
+   3 <= p < 2^256 given as 32 little-endian bytes, with as many rounds
+   as the size of p needs.
+   Returns 0 on success, -1 (leaving table untouched) otherwise. */
+
+static const int64_t header[20] = {
+  0x3FFFFFFFLL, 0x3FFFFFFFLL, 0x3FFFFFFFLL, 0x3FFFFFFFLL,
+  0x200000000LL, 0x200000000LL, 0x200000000LL, 0x200000000LL,
+  0x8000000000000000LL, 0x8000000000000000LL,
+  0x8000000000000000LL, 0x8000000000000000LL,
+  0X7FFFFFFE00000000LL, 0X7FFFFFFE00000000LL,
+  0X7FFFFFFE00000000LL, 0X7FFFFFFE00000000LL,
+  0x20000000LL, 0x20000000LL, 0x20000000LL, 0x20000000LL,
+} ;
+
+/* The largest size of modulus, in bits, that r rounds of 59 divsteps
+   cover, for r = 0..10: the certified bounds of "./divbound -t".  A
+   256-bit modulus needs all 10 rounds; P-224 sizes need 9, P-192
+   sizes 8. */
+
+static const long long roundbits[11] = {
+  0, 25, 51, 76, 102, 127, 153, 179, 204, 230, 256,
+} ;
+
+int inverse256_table_init(int64_t *table,const unsigned char *modulus)
+{
+  uint64_t p[4];
+  uint64_t pinv;
+  long long i,k,bits;
+
+  for (i = 0;i < 4;++i) {
+    p[i] = 0;
+    for (k = 7;k >= 0;--k) p[i] = (p[i]<<8)|modulus[8*i+k];
+  }
+
+  if (!(p[0]&1)) return -1;
+  if (p[0] == 1 && !(p[1]|p[2]|p[3])) return -1;
+
+  /* Newton iteration: each step doubles the number of correct bits,
+     starting from 3 bits since p*p = 1 mod 8 */
+  pinv = p[0];
+  for (i = 0;i < 5;++i) pinv *= 2-p[0]*pinv;
+
+  for (i = 0;i < 20;++i) table[i] = header[i];
+  for (i = 0;i < 4;++i) table[20+i] = p[i];
+  for (i = 24;i < 64;++i) table[i] = 0;
+  for (i = 0;i < 9;++i) {
+    k = 30*i;
+    table[24+4*i] = (p[k>>6]>>(k&63))&0x3fffffff;
+    if ((k&63) > 34 && (k>>6) < 3)
+      table[24+4*i] |= (p[(k>>6)+1]<<(64-(k&63)))&0x3fffffff;
+  }
+  table[31] = 1;
+  table[60] = -pinv;
+
+  bits = 0;
+  for (i = 0;i < 256;++i)
+    if ((p[i>>6]>>(i&63))&1) bits = i+1;
+  for (k = 1;roundbits[k] < bits;++k) ;
+  table[61] = k;
+  return 0;
+}
+
+/* The static tables in table.c for the built-in moduli; for any other,
+   a small per-thread cache of generated tables, keyed by the modulus,
+   so that callers cycling through a handful of moduli build each table
+   once.  Replacement is round-robin. */
+
+#define CACHESIZE 8
+
+static __thread struct {
+  int64_t table[64] __attribute__((aligned(32)));
+  unsigned char modulus[32];
+  int valid;
+} cache[CACHESIZE];
+static __thread int cachenext;
+
+const int64_t *inverse256_table_cached(const unsigned char *modulus)
+{
+  const int64_t *table = inverse256_table_builtin(modulus);
+  int i;
+
+  if (table) return table;
+  for (i = 0;i < CACHESIZE;++i)
+    if (cache[i].valid && memcmp(cache[i].modulus,modulus,32) == 0)
+      return cache[i].table;
+
+  i = cachenext;
+  if (inverse256_table_init(cache[i].table,modulus) != 0) return 0;
+  memcpy(cache[i].modulus,modulus,32);
+  cache[i].valid = 1;
+  cachenext = (i+1)%CACHESIZE;
+  return cache[i].table;
+}
+
+/* The asm reduces its input with a single subtraction of p, which is
+   enough for 2^255 < p but not for smaller moduli: a multiple of p
+   other than 0 and p would come back nonzero.  Reducing first makes
+   every modulus behave like the built-in ones. */
+
+int inverse256_generic(unsigned char *out,const unsigned char *in,const unsigned char *modulus)
+{
+  const int64_t *table = inverse256_table_cached(modulus);
+  uint64_t x[4];
+  unsigned char s[32];
+
+  if (!table) return -1;
+  mont256_load(x,in,table);
+  mont256_store(s,x);
+  inverse256_skylake_core(out,s,table);
+  return 0;
+}
@@ -0,0 +1,56 @@
+#include <stdint.h>
+#include "inverse256.h"
+#include "mont256.h"
+
+extern void (*inverse256_skylake_core)(unsigned char *,const unsigned char *,const int64_t *);
+
+/* Entry points on 64-bit limbs, for callers that keep numbers as
+   uint64_t[4] instead of 32-byte strings.  On a little-endian machine,
+   which is every machine asm.s runs on, limbs in little-endian order
+   are already the string the engines read and write, so
+   inverse256_limbs() hands the pointers straight to the engine and no
+   byte is moved.  Most significant limb first costs a reversal of four
+   words on each side.  The radix 2^30 output is the form of
+   inverse256_x4_soa(): 9 limbs of 30 bits, each in its own int64_t, so
+   that vector code can load them as they are. */
+
+void inverse256_limbs(uint64_t *out,const uint64_t *in,const int64_t *table)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  inverse256_skylake_core((unsigned char *) out,(const unsigned char *) in,table);
+#else
+  unsigned char s[32],t[32];
+  long long i,k;
+
+  mont256_store(s,in);
+  inverse256_skylake_core(t,s,table);
+  for (i = 0;i < 4;++i) {
+    out[i] = 0;
+    for (k = 7;k >= 0;--k) out[i] = (out[i]<<8)|t[8*i+k];
+  }
+#endif
+}
+
+void inverse256_limbs_be(uint64_t *out,const uint64_t *in,const int64_t *table)
+{
+  uint64_t x[4],y[4];
+  long long i;
+
+  for (i = 0;i < 4;++i) x[i] = in[3-i];
+  inverse256_limbs(y,x,table);
+  for (i = 0;i < 4;++i) out[i] = y[3-i];
+}
+
+void inverse256_limbs30(int64_t *out,const uint64_t *in,const int64_t *table)
+{
+  uint64_t y[4];
+  long long i,k;
+
+  inverse256_limbs(y,in,table);
+  for (i = 0;i < 9;++i) {
+    k = 30*i;
+    out[i] = (y[k>>6]>>(k&63))&0x3fffffff;
+    if ((k&63) > 34 && (k>>6) < 3)
+      out[i] |= (y[(k>>6)+1]<<(64-(k&63)))&0x3fffffff;
+  }
+}
@@ -0,0 +1,237 @@
+#define _GNU_SOURCE
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "measure.h"
+
+/* Counter 0 is the group leader and counts cycles; cpucycles() reads
+   it.  Each counter is read with rdpmc under the seqlock of its mmap
+   page, sign-extended from pmc_width bits and added to the kernel's
+   offset, so the values survive context switches. */
+
+#define EVENTS 3
+
+static const unsigned long long config[EVENTS] = {
+  PERF_COUNT_HW_CPU_CYCLES,
+  PERF_COUNT_HW_INSTRUCTIONS,
+  PERF_COUNT_HW_BRANCH_MISSES,
+} ;
+
+static struct perf_event_mmap_page *page[EVENTS];
+static int events; /* counters that rdpmc can read */
+static int initialized;
+static measure_config cfg = { 16, 1000, -1 };
+static int pincpu = -1;
+static long long overhead[EVENTS];
+
+static void openevents(void)
+{
+  struct perf_event_attr attr;
+  void *p;
+  int fd,leader = -1;
+
+  for (events = 0;events < EVENTS;++events) {
+    memset(&attr,0,sizeof attr);
+    attr.size = sizeof attr;
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config[events];
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    fd = syscall(__NR_perf_event_open,&attr,0,-1,leader,0);
+    if (fd == -1) return;
+    p = mmap(NULL,sysconf(_SC_PAGESIZE),PROT_READ,MAP_SHARED,fd,0);
+    if (p == MAP_FAILED) {
+      close(fd);
+      return;
+    }
+    if (!((struct perf_event_mmap_page *) p)->cap_user_rdpmc || !((struct perf_event_mmap_page *) p)->index) {
+      munmap(p,sysconf(_SC_PAGESIZE));
+      close(fd);
+      return;
+    }
+    page[events] = p;
+    if (leader == -1) leader = fd;
+  }
+}
+
+static long long readpmc(int i)
+{
+  struct perf_event_mmap_page *p = page[i];
+  unsigned int seq,index;
+  long long offset,pmc;
+  int width;
+
+  do {
+    seq = p->lock;
+    asm volatile("" ::: "memory");
+    index = p->index;
+    offset = p->offset;
+    width = p->pmc_width;
+    pmc = 0;
+    if (index) {
+      asm volatile("rdpmc;shlq $32,%%rdx;orq %%rdx,%%rax"
+        : "=a"(pmc) : "c"(index-1) : "%rdx");
+      pmc = (long long) ((uint64_t) pmc<<(64-width))>>(64-width);
+    }
+    asm volatile("" ::: "memory");
+  } while (p->lock != seq);
+
+  return offset+pmc;
+}
+
+long long cpucycles(void)
+{
+  long long result;
+
+  if (!initialized) measure_init(0);
+  if (events) return readpmc(0);
+
+  asm volatile(".byte 15;.byte 49;shlq $32,%%rdx;orq %%rdx,%%rax"
+    : "=a" (result) ::  "%rdx");
+  return result;
+}
+
+static void start(long long *t)
+{
+  int i;
+
+  for (i = 1;i < EVENTS;++i) t[i] = i < events ? readpmc(i) : 0;
+  t[0] = cpucycles();
+}
+
+static void stop(long long *t)
+{
+  int i;
+
+  t[0] = cpucycles();
+  for (i = 1;i < EVENTS;++i) t[i] = i < events ? readpmc(i) : 0;
+}
+
+static int cmp(const void *a,const void *b)
+{
+  long long x = *(const long long *) a;
+  long long y = *(const long long *) b;
+  return (x > y) - (x < y);
+}
+
+static long long isqrt(long long n)
+{
+  long long r = 0;
+
+  while ((r+1)*(r+1) <= n) ++r;
+  return r;
+}
+
+int measure(measure_result *r,void (*f)(void *),void *arg,long long ops)
+{
+  long long n = cfg.samples;
+  long long t0[EVENTS],t1[EVENTS];
+  long long *d;
+  long long s,w;
+  double sum = 0;
+  cpu_set_t saved,set;
+  int k,pinned;
+
+  if (!initialized) measure_init(0);
+  d = malloc(EVENTS*n*sizeof(long long));
+  if (!d) return -1;
+  if (ops < 1) ops = 1;
+
+  /* pinned for this run only: threads the caller starts later get the
+     mask it had, not this one CPU */
+  pinned = pincpu >= 0 && sched_getaffinity(0,sizeof saved,&saved) == 0;
+  if (pinned) {
+    CPU_ZERO(&set);
+    CPU_SET(pincpu,&set);
+    sched_setaffinity(0,sizeof set,&set);
+  }
+
+  for (s = -cfg.warmup;s < n;++s) {
+    start(t0);
+    f(arg);
+    stop(t1);
+    if (s >= 0)
+      for (k = 0;k < EVENTS;++k) {
+        d[k*n+s] = t1[k]-t0[k]-overhead[k];
+        if (d[k*n+s] < 0) d[k*n+s] = 0;
+      }
+  }
+  if (pinned) sched_setaffinity(0,sizeof saved,&saved);
+
+  for (k = 0;k < EVENTS;++k) qsort(d+k*n,n,sizeof(long long),cmp);
+  for (s = 0;s < n;++s) sum += d[s];
+
+  /* distribution-free: the median lies between order statistics
+     n/2 -+ 1.96 sqrt(n)/2 with 95% probability */
+  w = 98*isqrt(10000*n)/10000;
+
+  r->samples = n;
+  r->min = d[0]/(double) ops;
+  r->median = d[n/2]/(double) ops;
+  r->p90 = d[(n-1)*90/100]/(double) ops;
+  r->p99 = d[(n-1)*99/100]/(double) ops;
+  r->mean = sum/n/ops;
+  r->lo = d[n/2-w > 0 ? n/2-w : 0]/(double) ops;
+  r->hi = d[n/2+w < n-1 ? n/2+w : n-1]/(double) ops;
+  r->instructions = events > 1 ? d[n+n/2]/(double) ops : -1;
+  r->branchmisses = events > 2 ? d[2*n+n/2]/(double) ops : -1;
+
+  free(d);
+  return 0;
+}
+
+static void __attribute__((noinline)) nothing(void *arg)
+{
+  asm volatile("" ::: "memory");
+}
+
+/* Picks the CPU that measure() pins to, opens the counters on first
+   use, and measures an empty call, whose median is then taken off
+   every later sample.  0 uses the defaults: 16 warm-up calls, 1000
+   samples, the current CPU. */
+
+int measure_init(const measure_config *c)
+{
+  measure_result r;
+  int k;
+
+  if (c) cfg = *c;
+  if (cfg.samples < 1) cfg.samples = 1;
+  if (cfg.warmup < 0) cfg.warmup = 0;
+
+  pincpu = cfg.cpu >= 0 ? cfg.cpu : sched_getcpu();
+
+  if (!initialized) openevents();
+  initialized = 1;
+
+  for (k = 0;k < EVENTS;++k) overhead[k] = 0;
+  if (measure(&r,nothing,0,1) != 0) return -1;
+  overhead[0] = r.median;
+  overhead[1] = r.instructions > 0 ? r.instructions : 0;
+  overhead[2] = r.branchmisses > 0 ? r.branchmisses : 0;
+  return 0;
+}
+
+long long measure_overhead(void)
+{
+  if (!initialized) measure_init(0);
+  return overhead[0];
+}
+
+void measure_print(const char *name,const measure_result *r)
+{
+  printf("%s cycles median %.0f (95%% ci %.0f..%.0f) min %.0f p90 %.0f p99 %.0f mean %.0f",
+    name,r->median,r->lo,r->hi,r->min,r->p90,r->p99,r->mean);
+  if (r->instructions >= 0) printf(" instructions %.0f",r->instructions);
+  if (r->branchmisses >= 0) printf(" branch-misses %.2f",r->branchmisses);
+  printf("\n");
+  fflush(stdout);
+}
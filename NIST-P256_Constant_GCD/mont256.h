@@ -0,0 +1,18 @@
+#ifndef mont256_h
+#define mont256_h
+
+#include <stdint.h>
+
+/* Arithmetic modulo the prime described by a 64-entry inverse256 table:
+   the prime radix 2^64 sits in positions 20..23 and -1/p mod 2^64 in
+   position 60.  Field elements are 4 little-endian 64-bit limbs, fully
+   reduced.  Everything here runs in time independent of the inputs. */
+
+extern void mont256_load(uint64_t *,const unsigned char *,const int64_t *);
+extern void mont256_store(unsigned char *,const uint64_t *);
+extern void mont256_start(uint64_t *,const int64_t *);
+extern void mont256_mul(uint64_t *,const uint64_t *,const uint64_t *,const int64_t *);
+extern uint64_t mont256_iszero(const uint64_t *);
+extern void mont256_cmov(uint64_t *,const uint64_t *,uint64_t);
+
+#endif
@@ -0,0 +1,85 @@
+#include <stdint.h>
+#include "inverse256.h"
+#include "mont256.h"
+
+extern void (*inverse256_skylake_core)(unsigned char *,const unsigned char *,const int64_t *);
+
+/* Jacobian (X:Y:Z) to affine (X/Z^2,Y/Z^3) for n points in place, each
+   96 bytes: X, Y, Z as 32-byte little-endian strings.  Z becomes 1, or
+   stays 0 (mod p) for the point at infinity, whose X and Y become 0.
+
+   This is Montgomery's trick of batch.c with the squarings and
+   multiplications of the normalization folded into its backward pass,
+   CHUNK points at a time so that the running products stay in L1:
+   one inversion per chunk, then per point 1 multiplication forward
+   and 6 back.
+
+   With R = 2^256 and c_i = mont(c_(i-1),Z_i) = c_(i-1) Z_i/R, what
+   gets inverted is mont(c_n,1) = c_n/R, so that u = R/c_n.  Going
+   back, mont(u,Z_i) keeps u = R/c_i, and mont(u,c_(i-1)) = R/Z_i is
+   1/Z_i in Montgomery form: its square and cube take X and Y back out
+   of that form as they multiply them.  Zero Z are replaced by 1, and
+   their outputs cleared, in constant time. */
+
+#define CHUNK 256
+
+static const uint64_t one[4] = {1,0,0,0};
+
+static void clear(uint64_t *h,uint64_t mask)
+{
+  long long i;
+
+  for (i = 0;i < 4;++i) h[i] &= ~mask;
+}
+
+static void chunk(unsigned char *points,long long n,const int64_t *table)
+{
+  uint64_t c[CHUNK+1][4];
+  uint64_t u[4],z[4],w[4],w2[4],w3[4],x[4],y[4];
+  unsigned char s[32];
+  uint64_t zero;
+  long long i,j;
+
+  for (j = 0;j < 4;++j) c[0][j] = one[j];
+  for (i = 1;i <= n;++i) {
+    mont256_load(z,points+96*i-32,table);
+    mont256_cmov(z,one,mont256_iszero(z));
+    mont256_mul(c[i],c[i-1],z,table);
+  }
+
+  mont256_mul(u,c[n],one,table);
+  mont256_store(s,u);
+  inverse256_skylake_core(s,s,table);
+  mont256_load(u,s,table);
+
+  for (i = n;i > 0;--i) {
+    unsigned char *p = points+96*(i-1);
+
+    mont256_load(z,p+64,table);
+    zero = mont256_iszero(z);
+    mont256_cmov(z,one,zero);
+    mont256_mul(w,u,c[i-1],table);
+    mont256_mul(u,u,z,table);
+    mont256_mul(w2,w,w,table);
+    mont256_mul(w3,w2,w,table);
+    mont256_load(x,p,table);
+    mont256_load(y,p+32,table);
+    mont256_mul(x,x,w2,table);
+    mont256_mul(y,y,w3,table);
+    clear(x,zero);
+    clear(y,zero);
+    for (j = 0;j < 4;++j) z[j] = one[j];
+    clear(z,zero);
+    mont256_store(p,x);
+    mont256_store(p+32,y);
+    mont256_store(p+64,z);
+  }
+}
+
+void normalize_jacobian(unsigned char *points,long long n,const int64_t *table)
+{
+  long long i;
+
+  for (i = 0;i < n;i += CHUNK)
+    chunk(points+96*i,n-i < CHUNK ? n-i : CHUNK,table);
+}
@@ -0,0 +1,193 @@
+#define _GNU_SOURCE
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdint.h>
+#include "inverse256.h"
+
+/* Large batches on all cores: the array is cut into one contiguous
+   slice per thread, and each thread runs Montgomery's trick of
+   batch.c (or normalize.c) on its own slice, CHUNK elements per
+   inversion.  The slices share nothing: batch.c keeps its running
+   products in the output it is about to overwrite, so there is no
+   common scratch to fight over, and slice boundaries fall on even
+   records, which for buffers aligned to 64 bytes keeps every cache
+   line of the output in one thread.
+
+   The workers are started on first use and then wait on a condition
+   variable; worker i is pinned to the i-th CPU (mod their number) that
+   the process was allowed to run on when it started, so under taskset
+   or a container cpuset it stays inside the allowed set, on one node,
+   and, by the kernel's first-touch policy, the pages of a fresh output
+   buffer that it writes first are allocated there.  The set is read
+   by a constructor, before main() and anything in it (measure.c, say)
+   can narrow the affinity of the thread that starts the workers.  Each
+   worker's state has a cache line to itself.  Calls from several
+   threads are serialized.
+
+   threads <= 0 means one per allowed CPU.  Fewer threads are used when
+   n is small, so that a slice holds at least MINSLICE elements, and a
+   single slice runs in the calling thread without touching the pool. */
+
+#define MAXTHREADS 256
+#define CHUNK 4096
+#define MINSLICE 256
+
+typedef struct {
+  unsigned char *out;
+  const unsigned char *in;
+  long long n;
+  const int64_t *table;
+  long long threads;
+  int normalize;
+} job;
+
+typedef struct {
+  pthread_t id;
+  long long seen;
+} __attribute__((aligned(64))) worker;
+
+static worker workers[MAXTHREADS];
+
+static struct {
+  pthread_mutex_t lock;
+  pthread_cond_t go,done;
+  long long generation;
+  long long started;
+  long long pending;
+  job j;
+} __attribute__((aligned(64))) pool = {
+  PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER
+} ;
+
+static pthread_mutex_t calls = PTHREAD_MUTEX_INITIALIZER;
+
+static cpu_set_t allowed;
+static int cpu[CPU_SETSIZE];
+static long long cpus;
+
+static void __attribute__((constructor)) startmask(void)
+{
+  int i;
+
+  if (sched_getaffinity(0,sizeof allowed,&allowed) != 0) return;
+  for (i = 0;i < CPU_SETSIZE;++i)
+    if (CPU_ISSET(i,&allowed)) cpu[cpus++] = i;
+}
+
+/* first element of slice i of t; a multiple of 2 except at the end */
+
+static long long bound(long long n,long long i,long long t)
+{
+  if (i == t) return n;
+  return (long long) ((__int128) n*i/t)&~1LL;
+}
+
+static void slice(const job *j,long long i)
+{
+  long long lo = bound(j->n,i,j->threads);
+  long long hi = bound(j->n,i+1,j->threads);
+  long long m;
+
+  if (j->normalize) {
+    normalize_jacobian(j->out+96*lo,hi-lo,j->table);
+    return;
+  }
+  for (;lo < hi;lo += m) {
+    m = hi-lo;
+    if (m > CHUNK) m = CHUNK;
+    inverse256_batch(j->out+32*lo,j->in+32*lo,m,j->table);
+  }
+}
+
+static void pin(long long i)
+{
+  cpu_set_t set;
+
+  if (cpus < 1) return;
+  CPU_ZERO(&set);
+  CPU_SET(cpu[i%cpus],&set);
+  if (sched_setaffinity(0,sizeof set,&set) == 0) return;
+
+  /* CPU gone offline since: at least do not inherit a caller pinned to one CPU */
+  sched_setaffinity(0,sizeof allowed,&allowed);
+}
+
+static void *loop(void *arg)
+{
+  worker *w = arg;
+  long long i = w-workers;
+  job j;
+
+  pin(i);
+  pthread_mutex_lock(&pool.lock);
+  for (;;) {
+    while (w->seen == pool.generation) pthread_cond_wait(&pool.go,&pool.lock);
+    w->seen = pool.generation;
+    if (i >= pool.j.threads) continue;
+    j = pool.j;
+    pthread_mutex_unlock(&pool.lock);
+    slice(&j,i);
+    pthread_mutex_lock(&pool.lock);
+    if (--pool.pending == 0) pthread_cond_signal(&pool.done);
+  }
+  return 0;
+}
+
+static void run(job *j)
+{
+  long long t = j->threads;
+
+  if (t <= 0) t = cpus > 0 ? cpus : sysconf(_SC_NPROCESSORS_ONLN);
+  if (t > (j->n+MINSLICE-1)/MINSLICE) t = (j->n+MINSLICE-1)/MINSLICE;
+  if (t > MAXTHREADS) t = MAXTHREADS;
+  if (t < 1) t = 1;
+  j->threads = t;
+  if (t == 1) {
+    slice(j,0);
+    return;
+  }
+
+  pthread_mutex_lock(&calls);
+  pthread_mutex_lock(&pool.lock);
+  while (pool.started < t) {
+    workers[pool.started].seen = pool.generation;
+    if (pthread_create(&workers[pool.started].id,0,loop,&workers[pool.started]) != 0) break;
+    ++pool.started;
+  }
+  if (pool.started < t) {
+    /* out of threads: re-cut the job for the workers there are */
+    t = pool.started;
+    if (t < 1) t = 1;
+    j->threads = t;
+    if (t == 1) {
+      pthread_mutex_unlock(&pool.lock);
+      pthread_mutex_unlock(&calls);
+      slice(j,0);
+      return;
+    }
+  }
+  pool.j = *j;
+  pool.pending = t;
+  ++pool.generation;
+  pthread_cond_broadcast(&pool.go);
+  while (pool.pending) pthread_cond_wait(&pool.done,&pool.lock);
+  pthread_mutex_unlock(&pool.lock);
+  pthread_mutex_unlock(&calls);
+}
+
+void inverse256_batch_threads(unsigned char *out,const unsigned char *in,long long n,const int64_t *table,int threads)
+{
+  job j = { out, in, n, table, threads, 0 };
+
+  if (n <= 0) return;
+  run(&j);
+}
+
+void normalize_jacobian_threads(unsigned char *points,long long n,const int64_t *table,int threads)
+{
+  job j = { points, 0, n, table, threads, 1 };
+
+  if (n <= 0) return;
+  run(&j);
+}
@@ -0,0 +1,185 @@
+#include <stdint.h>
+#include "inverse256.h"
+#include "mont256.h"
+
+typedef __int128 int128;
+
+/* The same constant-time divstep inversion as asm.s, in plain C with
+   64x64->128 multiplications, for machines without AVX2.
+
+   Numbers are 5 signed limbs radix 2^62.  Each round runs 59 hddivsteps
+   (zeta = -(delta+1/2)) on the bottom limbs of f and g and records the
+   transition matrix, scaled to 2^62; 10 rounds give the 590 divsteps
+   that 256-bit inputs need, and smaller moduli need fewer (position 61
+   of the table, 0 meaning 10).  The matrix is then applied to [f,g], which
+   is divided by 2^62 exactly, and to [d,e], which is divided by 2^62
+   modulo p by adding the multiple of p that clears the bottom limb.
+
+   Only the prime radix 2^64 (positions 20..23), the starting e
+   (positions 27, 31, ..., 59), -1/p mod 2^64 (position 60) and the
+   round count are taken from the table, so any table accepted by the
+   asm works here. */
+
+#define M62 ((int64_t) (UINT64_MAX>>2))
+
+typedef struct {
+  int64_t u,v,q,r;
+} matrix;
+
+static int64_t divsteps_59(int64_t zeta,uint64_t f,uint64_t g,matrix *t)
+{
+  uint64_t u = 8,v = 0,q = 0,r = 8;
+  uint64_t c1,c2,x,y,z;
+  int i;
+
+  for (i = 3;i < 62;++i) {
+    c1 = zeta>>63;
+    c2 = -(g&1);
+    x = (f^c1)-c1;
+    y = (u^c1)-c1;
+    z = (v^c1)-c1;
+    g += x&c2;
+    q += y&c2;
+    r += z&c2;
+    c1 &= c2;
+    zeta = (zeta^c1)-1;
+    f += g&c1;
+    u += q&c1;
+    v += r&c1;
+    g >>= 1;
+    u <<= 1;
+    v <<= 1;
+  }
+  t->u = u;
+  t->v = v;
+  t->q = q;
+  t->r = r;
+  return zeta;
+}
+
+/* [d,e] = t [d,e] / 2^62 mod p, keeping both in (-2p,p) */
+
+static void update_de(int64_t *d,int64_t *e,const matrix *t,const int64_t *p,int64_t pinv)
+{
+  int64_t sd = d[4]>>63,se = e[4]>>63;
+  int64_t md = (t->u&sd)+(t->v&se);
+  int64_t me = (t->q&sd)+(t->r&se);
+  int128 cd,ce;
+  int i;
+
+  cd = (int128) t->u*d[0]+(int128) t->v*e[0];
+  ce = (int128) t->q*d[0]+(int128) t->r*e[0];
+  md -= (pinv*(uint64_t) cd+md)&M62;
+  me -= (pinv*(uint64_t) ce+me)&M62;
+  cd += (int128) p[0]*md;
+  ce += (int128) p[0]*me;
+  cd >>= 62;
+  ce >>= 62;
+  for (i = 1;i < 5;++i) {
+    cd += (int128) t->u*d[i]+(int128) t->v*e[i]+(int128) p[i]*md;
+    ce += (int128) t->q*d[i]+(int128) t->r*e[i]+(int128) p[i]*me;
+    d[i-1] = (int64_t) cd&M62;
+    e[i-1] = (int64_t) ce&M62;
+    cd >>= 62;
+    ce >>= 62;
+  }
+  d[4] = cd;
+  e[4] = ce;
+}
+
+/* [f,g] = t [f,g] / 2^62, exact */
+
+static void update_fg(int64_t *f,int64_t *g,const matrix *t)
+{
+  int128 cf,cg;
+  int i;
+
+  cf = (int128) t->u*f[0]+(int128) t->v*g[0];
+  cg = (int128) t->q*f[0]+(int128) t->r*g[0];
+  cf >>= 62;
+  cg >>= 62;
+  for (i = 1;i < 5;++i) {
+    cf += (int128) t->u*f[i]+(int128) t->v*g[i];
+    cg += (int128) t->q*f[i]+(int128) t->r*g[i];
+    f[i-1] = (int64_t) cf&M62;
+    g[i-1] = (int64_t) cg&M62;
+    cf >>= 62;
+    cg >>= 62;
+  }
+  f[4] = cf;
+  g[4] = cg;
+}
+
+static void carry(int64_t *r)
+{
+  int i;
+
+  for (i = 0;i < 4;++i) {
+    r[i+1] += r[i]>>62;
+    r[i] &= M62;
+  }
+}
+
+/* d in (-2p,p) to d*sign(f) in [0,p) */
+
+static void normalize(int64_t *d,int64_t f4,const int64_t *p)
+{
+  int64_t mask;
+  int i;
+
+  mask = d[4]>>63;
+  for (i = 0;i < 5;++i) d[i] += p[i]&mask;
+  mask = f4>>63;
+  for (i = 0;i < 5;++i) d[i] = (d[i]^mask)-mask;
+  carry(d);
+  mask = d[4]>>63;
+  for (i = 0;i < 5;++i) d[i] += p[i]&mask;
+  carry(d);
+}
+
+static void to62(int64_t *r,const uint64_t *a)
+{
+  r[0] = a[0]&M62;
+  r[1] = ((a[0]>>62)|(a[1]<<2))&M62;
+  r[2] = ((a[1]>>60)|(a[2]<<4))&M62;
+  r[3] = ((a[2]>>58)|(a[3]<<6))&M62;
+  r[4] = a[3]>>56;
+}
+
+static void from62(uint64_t *a,const int64_t *r)
+{
+  a[0] = r[0]|((uint64_t) r[1]<<62);
+  a[1] = (r[1]>>2)|((uint64_t) r[2]<<60);
+  a[2] = (r[2]>>4)|((uint64_t) r[3]<<58);
+  a[3] = (r[3]>>6)|((uint64_t) r[4]<<56);
+}
+
+void inverse256_portable(unsigned char *out,const unsigned char *in,const int64_t *table)
+{
+  int64_t p[5],f[5],g[5],d[5],e[5];
+  int64_t zeta = -1,pinv,rounds = table[61] ? table[61] : 10;
+  uint64_t a[4];
+  matrix t;
+  int i;
+
+  to62(p,(const uint64_t *) (table+20));
+  mont256_load(a,in,table);
+  to62(g,a);
+  for (i = 0;i < 5;++i) {
+    f[i] = p[i];
+    d[i] = 0;
+  }
+  pinv = (-table[60])&M62;
+  mont256_start(a,table);
+  to62(e,a);
+
+  for (i = 0;i < rounds;++i) {
+    zeta = divsteps_59(zeta,f[0],g[0],&t);
+    update_de(d,e,&t,p,pinv);
+    update_fg(f,g,&t);
+  }
+
+  normalize(d,f[4],p);
+  from62(a,d);
+  mont256_store(out,a);
+}
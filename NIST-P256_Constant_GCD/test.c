@@ -1,74 +1,20 @@
+#define _GNU_SOURCE
 #include <gmp.h>
 #include <string.h>
 #include <stdio.h>
 #include <assert.h>
 #include <unistd.h>
 #include <stdint.h>
-#include <sys/types.h>
-#include <sys/mman.h>
-#include <sys/syscall.h>
-#include <linux/perf_event.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <pthread.h>
+#include <sched.h>
 #include "inverse256.h"
+#include "mont256.h"
+#include "measure.h"
 #include <time.h>
 
-static long long cpucycles(void)
-{
-  static int rdpmcworks = 1;
-  long long result;
-
-  while (rdpmcworks) {
-    static int fdperf = -1;
-    static struct perf_event_mmap_page *buf = 0;
-#ifdef THREADING
-    unsigned int seq;
-    long long index;
-    long long offset;
-#endif
-
-    if (fdperf == -1) {
-      static struct perf_event_attr attr;
-      memset(&attr,0,sizeof attr);
-      attr.type = PERF_TYPE_HARDWARE;
-      attr.config = PERF_COUNT_HW_CPU_CYCLES;
-      attr.exclude_kernel = 1;
-      fdperf = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
-      if (fdperf == -1) {
-        rdpmcworks = 0;
-        break;
-      }
-      buf = mmap(NULL, sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED, fdperf, 0);
-      if (buf == 0) {
-        rdpmcworks = 0;
-        break;
-      }
-    }
-
-#ifdef THREADING
-    do {
-      seq = buf->lock;
-      asm volatile("" ::: "memory");
-      index = buf->index;
-      offset = buf->offset;
-      asm volatile("rdpmc;shlq $32,%%rdx;orq %%rdx,%%rax"
-        : "=a"(result) : "c"(index-1) : "%rdx");
-      asm volatile("" ::: "memory");
-    } while (buf->lock != seq);
-
-    result += offset;
-#else
-    asm volatile("rdpmc;shlq $32,%%rdx;orq %%rdx,%%rax"
-      : "=a"(result) : "c"(0) : "%rdx");
-#endif
-
-    result &= 0xffffffffffff;
-    return result;
-  }
-
-  asm volatile(".byte 15;.byte 49;shlq $32,%%rdx;orq %%rdx,%%rax"
-    : "=a" (result) ::  "%rdx");
-  return result;
-}
-
 void gmp_import(mpz_t z,const unsigned char *s,unsigned long long slen)
 {
   mpz_import(z,slen,-1,1,0,0,s);
@@ -89,15 +35,19 @@ unsigned char two256[33] = {
   1
 } ;
 
+/* doit_gmp() scratch is per thread, so that the sweeps can run in parallel;
+   each thread initializes its own copies */
 mpz_t two256_gmp;
-mpz_t x_gmp;
-mpz_t y_gmp;
-mpz_t xy_gmp;
-mpz_t z_gmp;
+__thread mpz_t x_gmp;
+__thread mpz_t y_gmp;
+__thread mpz_t xy_gmp;
+__thread mpz_t z_gmp;
 mpz_t t_gmp;
-mpz_t twop_gmp;
+__thread mpz_t twop_gmp;
+
+/* the original checks, through gmp */
 
-void doit(const unsigned char *x,mpz_t p_gmp,void (*inverse256)(unsigned char *,const unsigned char *))
+void doit_gmp(const unsigned char *x,mpz_t p_gmp,void (*inverse256)(unsigned char *,const unsigned char *))
 {
   unsigned char y[32];
   unsigned char z[32];
@@ -154,70 +104,1311 @@ void doit(const unsigned char *x,mpz_t p_gmp,void (*inverse256)(unsigned char *,
   }
 }
 
-long long t[64];
+/* The same checks without gmp: 4x64-bit limbs and mont256_mul(), no
+   allocation.  x*y = 1 (mod p) is tested as mont(x,y) = mont(1,1),
+   since both sides are then 1/2^256.  doit_gmp() still runs on the
+   inputs whose hash is 0 mod gmpsample (TEST_GMP, default 64; 0 turns
+   it off, 1 runs it on everything), so the fast path is cross-checked
+   on the same inputs for any thread count. */
+
+static long long gmpsample = 64;
+static const uint64_t one[4] = {1,0,0,0};
+
+static void limbs(uint64_t *h,const unsigned char *s)
+{
+  long long i,k;
+
+  for (i = 0;i < 4;++i) {
+    h[i] = 0;
+    for (k = 7;k >= 0;--k) h[i] = (h[i]<<8)|s[8*i+k];
+  }
+}
+
+static int less(const uint64_t *f,const uint64_t *g)
+{
+  long long i;
+
+  for (i = 3;i >= 0;--i)
+    if (f[i] != g[i]) return f[i] < g[i];
+  return 0;
+}
+
+/* h = f+g or f-g mod 2^256, returning the carry or borrow */
+
+static uint64_t add(uint64_t *h,const uint64_t *f,const uint64_t *g)
+{
+  unsigned __int128 c = 0;
+  long long i;
+
+  for (i = 0;i < 4;++i) {
+    c += (unsigned __int128) f[i]+g[i];
+    h[i] = (uint64_t) c;
+    c >>= 64;
+  }
+  return c;
+}
+
+static uint64_t sub(uint64_t *h,const uint64_t *f,const uint64_t *g)
+{
+  unsigned __int128 d;
+  uint64_t borrow = 0;
+  long long i;
+
+  for (i = 0;i < 4;++i) {
+    d = (unsigned __int128) f[i]-g[i]-borrow;
+    h[i] = (uint64_t) d;
+    borrow = (uint64_t) (d>>64)&1;
+  }
+  return borrow;
+}
+
+/* y < p, and x*y = 1 (mod p) unless x = 0 (mod p), when y = 0 */
+
+static void checkinverse(const unsigned char *x,const unsigned char *y,const int64_t *table,const uint64_t *rinv)
+{
+  const uint64_t *p = (const uint64_t *) (table+20);
+  uint64_t a[4],b[4],t[4];
+
+  limbs(b,y);
+  assert(less(b,p));
+  mont256_load(a,x,table);
+  mont256_mul(t,a,b,table);
+  if (memcmp(t,rinv,sizeof t) != 0) {
+    assert(mont256_iszero(b));
+    assert(mont256_iszero(a));
+  }
+}
+
+static unsigned long long hash(const unsigned char *x)
+{
+  unsigned long long h = 14695981039346656037ULL;
+  long long i;
+
+  for (i = 0;i < 32;++i) h = (h^x[i])*1099511628211ULL;
+  return h;
+}
+
+void doit(const unsigned char *x,mpz_t p_gmp,const unsigned char *modulus,void (*inverse256)(unsigned char *,const unsigned char *))
+{
+  const int64_t *table = inverse256_table_cached(modulus);
+  const uint64_t *p = (const uint64_t *) (table+20);
+  uint64_t rinv[4],u[4];
+  unsigned char y[32];
+  unsigned char z[32];
+
+  mont256_mul(rinv,one,one,table);
+
+  inverse256(y,x);
+  checkinverse(x,y,table,rinv);
+
+  inverse256(z,y);
+  checkinverse(y,z,table,rinv);
+
+  /* x - kp down to x mod p, and x + kp up to 2^256, invert alike */
+  limbs(u,x);
+  while (!less(u,p)) {
+    sub(u,u,p);
+    mont256_store(z,u);
+    inverse256(z,z);
+    assert(memcmp(y,z,32) == 0);
+  }
+
+  limbs(u,x);
+  while (!add(u,u,p)) {
+    mont256_store(z,u);
+    inverse256(z,z);
+    assert(memcmp(y,z,32) == 0);
+  }
+
+  if (gmpsample && hash(x)%gmpsample == 0) doit_gmp(x,p_gmp,inverse256);
+}
+
 unsigned char x[32];
 
+/* The timings below go through measure.c: pinned, warmed up, with the
+   cost of an empty sample (the "nothing" row) taken off. */
+
+static void single(void *arg)
+{
+  inverse256_BTC_p(x,x);
+}
+
 void bench(void)
+{
+  measure_result r;
+
+  measure_init(0);
+  printf("nothing cycles %lld\n",measure_overhead());
+  measure(&r,single,0,1);
+  measure_print("inverse256_BTC_p",&r);
+}
+
+#define BATCH 1024
+unsigned char batchin[32*BATCH];
+unsigned char batchout[32*BATCH];
+
+static void batch(void *arg)
+{
+  inverse256_BTC_p_batch(batchout,batchin,*(long long *) arg);
+}
+
+/* cycles per element of inverse256_BTC_p_batch as n grows;
+   n = 1 is one inversion plus the conversions, so the crossover
+   against the single inversion above is where batching starts to pay */
+
+void bench_batch(void)
+{
+  measure_result r;
+  long long i,n;
+
+  for (i = 0;i < 32*BATCH;++i) batchin[i] = i*37+(i>>5);
+
+  for (n = 1;n <= BATCH;n *= 2) {
+    measure(&r,batch,&n,n);
+    printf("batch %lld cycles/element %.0f\n",n,r.median);
+  }
+
+  fflush(stdout);
+}
+
+static void serial4(void *arg)
+{
+  inverse256_BTC_p(batchout,batchin);
+  inverse256_BTC_p(batchout+32,batchin+32);
+  inverse256_BTC_p(batchout+64,batchin+64);
+  inverse256_BTC_p(batchout+96,batchin+96);
+}
+
+static void x4(void *arg)
+{
+  inverse256_BTC_p_x4((void *) batchout,(void *) batchin);
+}
+
+/* four serial inversions against one 4-lane call */
+
+void bench_x4(void)
+{
+  measure_result serial,lanes;
+
+  measure(&serial,serial4,0,1);
+  measure(&lanes,x4,0,1);
+  printf("x4 cycles/4 inversions serial %.0f x4 %.0f speedup %.2f\n",serial.median,lanes.median,serial.median/lanes.median);
+  fflush(stdout);
+}
+
+static void portable(void *arg)
+{
+  inverse256_portable(x,x,arg);
+}
+
+/* the dispatched engine against the portable one, single inversions */
+
+void bench_portable(void)
+{
+  const int64_t *table = inverse256_table_cached(inverse256_BTC_p_modulus);
+  measure_result core,port;
+
+  measure(&core,single,0,1);
+  measure(&port,portable,(void *) table,1);
+  printf("engine %s cycles %.0f portable cycles %.0f\n",inverse256_implementation(),core.median,port.median);
+  fflush(stdout);
+}
+
+static long long pool;
+
+static void single_random(void *arg)
+{
+  inverse256_BTC_p(batchout,batchin+32*(pool++%BATCH));
+}
+
+static void portable_random(void *arg)
+{
+  inverse256_portable(batchout,batchin+32*(pool++%BATCH),arg);
+}
+
+static void vartime_random(void *arg)
+{
+  inverse256_BTC_p_vartime(batchout,batchin+32*(pool++%BATCH));
+}
+
+static void vartime_portable_random(void *arg)
+{
+  inverse256_vartime_portable(batchout,batchin+32*(pool++%BATCH),arg);
+}
+
+/* the C engine of vartime.c against portable.c, which it replaces
+   without AVX2, and the variable-time entry point, all over the same
+   BATCH random inputs; vartime is only for public inputs, and its
+   mean is what a verifier sees.  With AVX2 the entry point is the
+   constant-time asm, so no speedup is printed for it */
+
+void bench_vartime(void)
+{
+  const int64_t *table = inverse256_table_cached(inverse256_BTC_p_modulus);
+  measure_result ct,port,vt,vc;
+  long long i;
+
+  for (i = 0;i < 32*BATCH;++i) batchin[i] = random();
+
+  measure(&ct,single_random,0,1);
+  measure(&port,portable_random,(void *) table,1);
+  measure(&vt,vartime_random,0,1);
+  measure(&vc,vartime_portable_random,(void *) table,1);
+  printf("vartime.c cycles mean %.0f, portable %.0f (speedup %.2f); _vartime entry point %.0f, %s %.0f\n",
+    vc.mean,port.mean,port.mean/vc.mean,vt.mean,inverse256_implementation(),ct.mean);
+  fflush(stdout);
+}
+
+static void jacobi_random(void *arg)
+{
+  pool += jacobi256_BTC_p(batchin+32*(pool%BATCH))+2;
+}
+
+static void jacobi_vartime_random(void *arg)
+{
+  pool += jacobi256_BTC_p_vartime(batchin+32*(pool%BATCH))+2;
+}
+
+static mpz_t powm_p,powm_e;
+
+static void powm_random(void *arg)
+{
+  gmp_import(x_gmp,batchin+32*(pool++%BATCH),32);
+  mpz_powm_sec(y_gmp,x_gmp,powm_e,powm_p);
+}
+
+/* the symbol against Euler's criterion x^((p-1)/2), the exponentiation
+   it replaces, here through gmp's constant-time mpz_powm_sec */
+
+void bench_jacobi(void)
+{
+  measure_result ct,vt,powm;
+
+  mpz_inits(powm_p,powm_e,NULL);
+  gmp_import(powm_p,inverse256_BTC_p_modulus,32);
+  mpz_sub_ui(powm_e,powm_p,1);
+  mpz_fdiv_q_2exp(powm_e,powm_e,1);
+  measure(&ct,jacobi_random,0,1);
+  measure(&vt,jacobi_vartime_random,0,1);
+  measure(&powm,powm_random,0,1);
+  printf("jacobi cycles median %.0f, vartime %.0f, mpz_powm_sec %.0f\n",ct.median,vt.median,powm.median);
+  fflush(stdout);
+  mpz_clears(powm_p,powm_e,NULL);
+}
+
+#define POINTS 512
+static unsigned char points[96*POINTS];
+static const int64_t *normtable;
+static uint64_t normr2[4];
+
+/* what a caller does without normalize_jacobian(): an inversion per
+   point, into Montgomery form by 2^512 mod p, then the same 4
+   multiplications */
+
+static void normalize_naive(void *arg)
+{
+  static const uint64_t one[4] = {1,0,0,0};
+  uint64_t w[4],w2[4],w3[4],a[4],b[4];
+  unsigned char s[32];
+  long long i;
+
+  for (i = 0;i < POINTS;++i) {
+    unsigned char *p = points+96*i;
+    inverse256_P256_p(s,p+64);
+    mont256_load(w,s,normtable);
+    mont256_mul(w,w,normr2,normtable);
+    mont256_mul(w2,w,w,normtable);
+    mont256_mul(w3,w2,w,normtable);
+    mont256_load(a,p,normtable);
+    mont256_load(b,p+32,normtable);
+    mont256_mul(a,a,w2,normtable);
+    mont256_mul(b,b,w3,normtable);
+    mont256_store(p,a);
+    mont256_store(p+32,b);
+    mont256_store(p+64,one);
+  }
+}
+
+static void normalize_fused(void *arg)
+{
+  normalize_jacobian_P256_p(points,POINTS);
+}
+
+/* cycles per point; after the first call Z is 1 everywhere, which
+   changes nothing for constant-time code */
+
+void bench_normalize(void)
+{
+  measure_result naive,fused;
+  long long i;
+
+  normtable = inverse256_table_cached(inverse256_P256_p_modulus);
+  gmp_import(t_gmp,inverse256_P256_p_modulus,32);
+  mpz_set_ui(z_gmp,0);
+  mpz_setbit(z_gmp,512);
+  mpz_mod(z_gmp,z_gmp,t_gmp);
+  assert(gmp_export((unsigned char *) normr2,32,z_gmp) == 0);
+  for (i = 0;i < 96*POINTS;++i) points[i] = random();
+  for (i = 0;i < POINTS;++i) points[96*i+95] &= 0x7f;
+
+  measure(&naive,normalize_naive,0,POINTS);
+  measure(&fused,normalize_fused,0,POINTS);
+  printf("normalize_jacobian cycles/point naive %.0f fused %.0f speedup %.2f\n",naive.median,fused.median,naive.median/fused.median);
+  fflush(stdout);
+}
+
+/* wall-clock scaling of the thread pool, best of 5, from 1 thread to
+   one per online CPU; cycle counters only see the calling thread */
+
+#define SCALEBATCH (1<<18)
+#define SCALEPOINTS (1<<17)
+
+static double seconds(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC,&t);
+  return t.tv_sec+t.tv_nsec*1e-9;
+}
+
+static double fastest(long long what,unsigned char *out,const unsigned char *in,int threads)
+{
+  double best = 1e30,t;
+  long long r;
+
+  for (r = 0;r < 5;++r) {
+    t = seconds();
+    if (what) normalize_jacobian_threads(out,SCALEPOINTS,normtable,threads);
+    else inverse256_batch_threads(out,in,SCALEBATCH,normtable,threads);
+    t = seconds()-t;
+    if (t < best) best = t;
+  }
+  return best;
+}
+
+void bench_threads(void)
+{
+  long long cpus = sysconf(_SC_NPROCESSORS_ONLN),t,i;
+  unsigned char *in = aligned_alloc(64,32*SCALEBATCH);
+  unsigned char *out = aligned_alloc(64,96*SCALEPOINTS);
+  double batch1 = 0,norm1 = 0,b,n;
+  cpu_set_t set;
+
+  assert(in && out);
+  if (sched_getaffinity(0,sizeof set,&set) == 0) cpus = CPU_COUNT(&set);
+  if (cpus < 1) cpus = 1;
+  for (i = 0;i < 32*SCALEBATCH;++i) in[i] = random();
+  for (i = 0;i < SCALEBATCH;++i) in[32*i+31] &= 0x7f;
+
+  for (t = 1;t <= cpus;t = t < cpus && 2*t > cpus ? cpus : 2*t) {
+    b = fastest(0,out,in,t);
+    for (i = 0;i < 96*SCALEPOINTS;++i) out[i] = in[i%(32*SCALEBATCH)];
+    n = fastest(1,out,0,t);
+    if (t == 1) { batch1 = b; norm1 = n; }
+    printf("threads %lld batch ns/element %.1f (speedup %.2f) normalize_jacobian ns/point %.1f (speedup %.2f)\n",
+      t,1e9*b/SCALEBATCH,batch1/b,1e9*n/SCALEPOINTS,norm1/n);
+    fflush(stdout);
+  }
+  free(in);
+  free(out);
+}
+
+/* deferred inversion under load: CTXTHREADS callers, each with up to
+   CTXWINDOW elements in flight, against one inversion per element;
+   wall-clock ns/element and the worst put-to-get latency */
+
+#define CTXTHREADS 8
+#define CTXWINDOW 8
+#define CTXELEMENTS 4000
+#define CTXSIZE 64
+#define CTXDEADLINE 100000
+
+/* put, or when the ring has no room invert without the context and
+   return -1 with the inverse in y: these callers keep handles across
+   puts, so waiting for room could mean waiting for their own */
+
+static long long ctxput(inverse256_ctx *c,unsigned char *y,const unsigned char *x,const int64_t *table)
+{
+  long long h = inverse256_ctx_put(c,x);
+
+  if (h < 0) {
+    assert(errno == EAGAIN);
+    inverse256_batch(y,x,1,table);
+  }
+  return h;
+}
+
+typedef struct {
+  inverse256_ctx *c;
+  long long worst;
+} caller;
+
+static void *callers(void *arg)
+{
+  caller *k = arg;
+  unsigned char x[CTXWINDOW][32],y[CTXWINDOW][32];
+  long long h[CTXWINDOW],t[CTXWINDOW],i,j,d;
+
+  k->worst = 0;
+  for (i = 0;i < CTXELEMENTS;i += CTXWINDOW) {
+    for (j = 0;j < CTXWINDOW;++j) {
+      x[j][0] = i+j+1;
+      memset(x[j]+1,0x5a,31);
+      t[j] = seconds()*1e9;
+      h[j] = ctxput(k->c,y[j],x[j],normtable);
+    }
+    for (j = 0;j < CTXWINDOW;++j) {
+      if (h[j] >= 0) inverse256_ctx_get(k->c,y[j],h[j]);
+      d = seconds()*1e9-t[j];
+      if (d > k->worst) k->worst = d;
+    }
+  }
+  return 0;
+}
+
+void bench_ctx(void)
+{
+  static const int threaded[] = { 0, 1 } ;
+  caller k[CTXTHREADS];
+  pthread_t id[CTXTHREADS];
+  unsigned char x[32],y[32];
+  double single,t;
+  long long i,m,worst;
+
+  memset(x,0x5a,32);
+  memset(y,0,32);
+  t = seconds();
+  for (i = 0;i < CTXELEMENTS;++i) {
+    x[0] = i+y[0];
+    inverse256_batch(y,x,1,normtable);
+  }
+  single = (seconds()-t)/CTXELEMENTS;
+
+  for (m = 0;m < 2;++m) {
+    inverse256_ctx *c = inverse256_ctx_new(normtable,CTXSIZE,CTXDEADLINE,threaded[m]);
+    assert(c);
+    t = seconds();
+    for (i = 0;i < CTXTHREADS;++i) {
+      k[i].c = c;
+      assert(pthread_create(&id[i],0,callers,&k[i]) == 0);
+    }
+    worst = 0;
+    for (i = 0;i < CTXTHREADS;++i) {
+      assert(pthread_join(id[i],0) == 0);
+      if (k[i].worst > worst) worst = k[i].worst;
+    }
+    t = (seconds()-t)/(CTXTHREADS*CTXELEMENTS);
+    inverse256_ctx_free(c);
+    printf("inverse256_ctx %s ns/element %.0f (single %.0f, speedup %.2f) worst latency %lld us, deadline %d us\n",
+      threaded[m] ? "worker" : "callers",1e9*t,1e9*single,single/t,worst/1000,CTXDEADLINE/1000);
+    fflush(stdout);
+  }
+}
+
+gmp_randstate_t batchrand;
+
+/* batch results must match the single-element API, including the
+   zero and multiple-of-p elements that are mixed in */
+
+void checkbatch(mpz_t p_gmp,void (*inverse256)(unsigned char *,const unsigned char *),void (*batch)(unsigned char *,const unsigned char *,long long))
+{
+  long long i,n;
+  unsigned char y[32];
+
+  for (n = 1;n <= 64;++n) {
+    for (i = 0;i < n;++i) {
+      mpz_urandomb(x_gmp,batchrand,256);
+      if (i%7 == 3) mpz_set_ui(x_gmp,0);
+      if (i%11 == 5) mpz_set(x_gmp,p_gmp);
+      assert(gmp_export(batchin+32*i,32,x_gmp) == 0);
+    }
+    batch(batchout,batchin,n);
+    for (i = 0;i < n;++i) {
+      inverse256(y,batchin+32*i);
+      assert(memcmp(y,batchout+32*i,32) == 0);
+    }
+  }
+}
+
+/* generated tables must reproduce the hand-built ones, and must also
+   handle moduli well below 2^256, where inputs can be many multiples
+   of p */
+
+void checkgeneric(mpz_t p_gmp,const unsigned char *modulus,void (*inverse256)(unsigned char *,const unsigned char *))
+{
+  long long i,bits;
+  unsigned char m[32];
+  unsigned char y[32];
+  unsigned char z[32];
+
+  for (i = 0;i < 1000;++i) {
+    mpz_urandomb(x_gmp,batchrand,256);
+    assert(gmp_export(x,32,x_gmp) == 0);
+    inverse256(y,x);
+    assert(inverse256_generic(z,x,modulus) == 0);
+    assert(memcmp(y,z,32) == 0);
+  }
+
+  for (bits = 16;bits <= 256;bits += 16) {
+    do {
+      mpz_urandomb(t_gmp,batchrand,bits);
+      mpz_setbit(t_gmp,bits-1);
+    } while (!mpz_probab_prime_p(t_gmp,20));
+    assert(gmp_export(m,32,t_gmp) == 0);
+    for (i = 0;i < 100;++i) {
+      mpz_urandomb(x_gmp,batchrand,256);
+      if (i%10 == 0 && bits <= 248) mpz_mul_ui(x_gmp,t_gmp,i/10+1);
+      assert(gmp_export(x,32,x_gmp) == 0);
+      assert(inverse256_generic(y,x,m) == 0);
+      gmp_import(y_gmp,y,32);
+      if (!mpz_invert(z_gmp,x_gmp,t_gmp)) mpz_set_ui(z_gmp,0);
+      assert(mpz_cmp(y_gmp,z_gmp) == 0);
+    }
+  }
+
+  memcpy(m,modulus,32);
+  m[0] ^= 1;
+  assert(inverse256_generic(y,x,m) == -1);
+  memset(m,0,32);
+  m[0] = 1;
+  assert(inverse256_generic(y,x,m) == -1);
+}
+
+/* the round count at position 61 must follow the size of the modulus,
+   with sizes on either side of each boundary of roundbits[] in
+   generic.c; the engines must still invert there with fewer rounds */
+
+static const long long roundsizes[][2] = {
+  {2,1}, {25,1}, {26,2}, {51,2}, {52,3}, {76,3}, {77,4}, {102,4},
+  {103,5}, {127,5}, {128,6}, {153,6}, {154,7}, {179,7}, {180,8},
+  {204,8}, {205,9}, {230,9}, {231,10}, {256,10},
+} ;
+
+void checkrounds(const unsigned char *modulus)
+{
+  int64_t table[64];
+  long long i,j,n,bits;
+  unsigned char m[32];
+  unsigned char y[32];
+  unsigned char in[4][32];
+  unsigned char out[4][32];
+
+  assert(inverse256_table_init(table,modulus) == 0);
+  assert(table[61] == 10);
+
+  for (n = 0;n < sizeof roundsizes/sizeof roundsizes[0];++n) {
+    bits = roundsizes[n][0];
+    if (bits == 2)
+      mpz_set_ui(t_gmp,3);
+    else
+      do {
+        mpz_urandomb(t_gmp,batchrand,bits);
+        mpz_setbit(t_gmp,bits-1);
+      } while (!mpz_probab_prime_p(t_gmp,20));
+    assert(gmp_export(m,32,t_gmp) == 0);
+    assert(inverse256_table_init(table,m) == 0);
+    assert(table[61] == roundsizes[n][1]);
+
+    for (i = 0;i < 100;++i) {
+      for (j = 0;j < 4;++j) {
+        mpz_urandomb(x_gmp,batchrand,256);
+        if (i%10 == 0) mpz_sub_ui(x_gmp,t_gmp,j);
+        if (i%10 == 1 && bits <= 248) mpz_mul_ui(x_gmp,t_gmp,j+2);
+        assert(gmp_export(in[j],32,x_gmp) == 0);
+      }
+      inverse256_x4(out,(const unsigned char (*)[32]) in,table);
+      for (j = 0;j < 4;++j) {
+        gmp_import(x_gmp,in[j],32);
+        if (!mpz_invert(z_gmp,x_gmp,t_gmp)) mpz_set_ui(z_gmp,0);
+        assert(inverse256_generic(y,in[j],m) == 0);
+        gmp_import(y_gmp,y,32);
+        assert(mpz_cmp(y_gmp,z_gmp) == 0);
+        inverse256_portable(y,in[j],table);
+        gmp_import(y_gmp,y,32);
+        assert(mpz_cmp(y_gmp,z_gmp) == 0);
+        gmp_import(y_gmp,out[j],32);
+        assert(mpz_cmp(y_gmp,z_gmp) == 0);
+      }
+    }
+  }
+}
+
+/* every lane of the 4-way engine must agree with the asm */
+
+void checkx4(mpz_t p_gmp,void (*inverse256)(unsigned char *,const unsigned char *),void (*x4)(unsigned char (*)[32],const unsigned char (*)[32]))
 {
   long long i,j;
-  
-  for (i = 0;i < 64;++i)
-    t[i] = cpucycles();
-  for (i = 63;i > 0;--i)
-    t[i] -= t[i-1];
-
-  printf("nothing");
-  for (i = 1;i < 64;++i)
-    printf(" %lld",t[i]);
-  printf("\n");
-
-  for (i = 0;i < 64;++i) {
-    t[i] = cpucycles();
-    inverse256_BTC_p(x,x);
-  }
-  for (i = 63;i > 0;--i)
-    t[i] -= t[i-1];
-
-  printf("cycles");
-  for (i = 1;i < 64;++i)
-    printf(" %lld",t[i]);
-  printf("\n");
-
-  for (i = 1;i < 64;++i)
-    for (j = 1;j < i;++j)
-      if (t[i] < t[j]) {
-        long long ti = t[i];
-        t[i] = t[j];
-        t[j] = ti;
+  unsigned char in[4][32];
+  unsigned char out[4][32];
+  unsigned char y[32];
+
+  for (i = 0;i < 2000;++i) {
+    for (j = 0;j < 4;++j) {
+      mpz_urandomb(x_gmp,batchrand,256);
+      if ((i+j)%13 == 0) mpz_set_ui(x_gmp,0);
+      if ((i+j)%17 == 0) mpz_set(x_gmp,p_gmp);
+      if ((i+j)%19 == 0) mpz_set_ui(x_gmp,i);
+      assert(gmp_export(in[j],32,x_gmp) == 0);
+    }
+    x4(out,(const unsigned char (*)[32]) in);
+    for (j = 0;j < 4;++j) {
+      inverse256(y,in[j]);
+      assert(memcmp(y,out[j],32) == 0);
+    }
+  }
+}
+
+/* the portable engine must agree with whichever engine was picked,
+   and with gmp for moduli of every size */
+
+void checkportable(mpz_t p_gmp,const unsigned char *modulus,void (*inverse256)(unsigned char *,const unsigned char *))
+{
+  const int64_t *table = inverse256_table_cached(modulus);
+  long long i,bits;
+  unsigned char m[32];
+  unsigned char y[32];
+  unsigned char z[32];
+
+  for (i = 0;i < 2000;++i) {
+    mpz_urandomb(x_gmp,batchrand,256);
+    if (i%13 == 0) mpz_set_ui(x_gmp,i);
+    if (i%17 == 0) mpz_set(x_gmp,p_gmp);
+    if (i%19 == 0) mpz_sub_ui(x_gmp,two256_gmp,i+1);
+    assert(gmp_export(x,32,x_gmp) == 0);
+    inverse256(y,x);
+    inverse256_portable(z,x,table);
+    assert(memcmp(y,z,32) == 0);
+  }
+
+  for (bits = 16;bits <= 256;bits += 48) {
+    do {
+      mpz_urandomb(t_gmp,batchrand,bits);
+      mpz_setbit(t_gmp,bits-1);
+    } while (!mpz_probab_prime_p(t_gmp,20));
+    assert(gmp_export(m,32,t_gmp) == 0);
+    table = inverse256_table_cached(m);
+    for (i = 0;i < 100;++i) {
+      mpz_urandomb(x_gmp,batchrand,256);
+      if (i%10 == 0 && bits <= 248) mpz_mul_ui(x_gmp,t_gmp,i/10+1);
+      assert(gmp_export(x,32,x_gmp) == 0);
+      inverse256_portable(y,x,table);
+      gmp_import(y_gmp,y,32);
+      if (!mpz_invert(z_gmp,x_gmp,t_gmp)) mpz_set_ui(z_gmp,0);
+      assert(mpz_cmp(y_gmp,z_gmp) == 0);
+    }
+  }
+}
+
+/* the variable-time entry points and the C engine behind them without
+   AVX2 must agree with the constant-time one, including on inputs
+   that end early or late (0, multiples of p, small numbers, powers of
+   2), and with gmp for moduli of every size */
+
+void checkvartime(mpz_t p_gmp,const unsigned char *modulus,void (*inverse256)(unsigned char *,const unsigned char *),void (*vartime)(unsigned char *,const unsigned char *))
+{
+  const int64_t *table = inverse256_table_cached(modulus);
+  long long i,bits;
+  unsigned char m[32];
+  unsigned char y[32];
+  unsigned char z[32];
+
+  for (i = 0;i < 4000;++i) {
+    mpz_urandomb(x_gmp,batchrand,256);
+    if (i%13 == 0) mpz_set_ui(x_gmp,i);
+    if (i%17 == 0) mpz_mul_ui(x_gmp,p_gmp,i%2);
+    if (i%19 == 0) mpz_sub_ui(x_gmp,p_gmp,i);
+    if (i%23 == 0) mpz_sub_ui(x_gmp,two256_gmp,i+1);
+    if (i%29 == 0) { mpz_set_ui(x_gmp,0); mpz_setbit(x_gmp,i%256); }
+    assert(gmp_export(x,32,x_gmp) == 0);
+    inverse256(y,x);
+    vartime(z,x);
+    assert(memcmp(y,z,32) == 0);
+    inverse256_vartime_portable(z,x,table);
+    assert(memcmp(y,z,32) == 0);
+  }
+
+  for (bits = 16;bits <= 256;bits += 48) {
+    do {
+      mpz_urandomb(t_gmp,batchrand,bits);
+      mpz_setbit(t_gmp,bits-1);
+    } while (!mpz_probab_prime_p(t_gmp,20));
+    assert(gmp_export(m,32,t_gmp) == 0);
+    table = inverse256_table_cached(m);
+    for (i = 0;i < 100;++i) {
+      mpz_urandomb(x_gmp,batchrand,256);
+      if (i%10 == 0 && bits <= 248) mpz_mul_ui(x_gmp,t_gmp,i/10+1);
+      assert(gmp_export(x,32,x_gmp) == 0);
+      inverse256_vartime(y,x,table);
+      gmp_import(y_gmp,y,32);
+      if (!mpz_invert(z_gmp,x_gmp,t_gmp)) mpz_set_ui(z_gmp,0);
+      assert(mpz_cmp(y_gmp,z_gmp) == 0);
+      inverse256_vartime_portable(z,x,table);
+      assert(memcmp(y,z,32) == 0);
+    }
+  }
+}
+
+/* the symbol, its batch and its variable-time form must all match
+   mpz_jacobi, for the built-in modulus and for odd moduli of every
+   size, prime or not, down to 3 */
+
+#define JACOBI 64
+
+void checkjacobi(mpz_t p_gmp,int (*jacobi)(const unsigned char *),void (*jacobi_batch)(int *,const unsigned char *,long long),int (*jacobi_vartime)(const unsigned char *))
+{
+  const int64_t *table;
+  static unsigned char in[32*JACOBI];
+  int out[JACOBI];
+  long long i,j,bits;
+  unsigned char m[32];
+  int e;
+
+  for (i = 0;i < 200;++i) {
+    for (j = 0;j < JACOBI;++j) {
+      mpz_urandomb(x_gmp,batchrand,256);
+      if (j%13 == 0) mpz_set_ui(x_gmp,i*JACOBI+j);
+      if (j%17 == 0) mpz_mul_ui(x_gmp,p_gmp,j%2);
+      if (j%19 == 0) mpz_sub_ui(x_gmp,p_gmp,i+1);
+      if (j%23 == 0) mpz_sub_ui(x_gmp,two256_gmp,i+1);
+      if (j%29 == 0) { mpz_set_ui(x_gmp,0); mpz_setbit(x_gmp,(i+j)%256); }
+      assert(gmp_export(in+32*j,32,x_gmp) == 0);
+    }
+    jacobi_batch(out,in,JACOBI);
+    for (j = 0;j < JACOBI;++j) {
+      gmp_import(x_gmp,in+32*j,32);
+      e = mpz_jacobi(x_gmp,p_gmp);
+      assert(jacobi(in+32*j) == e);
+      assert(jacobi_vartime(in+32*j) == e);
+      assert(out[j] == e);
+    }
+  }
+
+  for (bits = 2;bits <= 256;++bits) {
+    mpz_urandomb(t_gmp,batchrand,bits);
+    mpz_setbit(t_gmp,bits-1);
+    mpz_setbit(t_gmp,0);
+    if (bits%4 == 0) mpz_mul(t_gmp,t_gmp,t_gmp);
+    mpz_tdiv_r_2exp(t_gmp,t_gmp,bits);
+    mpz_setbit(t_gmp,0);
+    if (mpz_cmp_ui(t_gmp,3) < 0) mpz_set_ui(t_gmp,3);
+    assert(gmp_export(m,32,t_gmp) == 0);
+    table = inverse256_table_cached(m);
+    for (i = 0;i < 50;++i) {
+      mpz_urandomb(x_gmp,batchrand,256);
+      if (i%10 == 0) mpz_mul_ui(x_gmp,t_gmp,i/10);
+      if (i%10 == 1) mpz_sub_ui(x_gmp,t_gmp,i/10+1);
+      if (i%10 == 2) mpz_set_ui(x_gmp,i);
+      if (mpz_sizeinbase(x_gmp,2) > 256 || mpz_sgn(x_gmp) < 0) mpz_set_ui(x_gmp,i);
+      assert(gmp_export(x,32,x_gmp) == 0);
+      e = mpz_jacobi(x_gmp,t_gmp);
+      assert(jacobi256(x,table) == e);
+      assert(jacobi256_vartime(x,table) == e);
+    }
+  }
+}
+
+/* the Montgomery forms must give R^2/x mod p for R = 2^256, through
+   the engine chosen at load time, and through the portable, 4-way and
+   variable-time ones, which run on a generated table given the
+   starting e of the _mont tables */
+
+void checkmont(mpz_t p_gmp,const unsigned char *modulus,void (*mont)(unsigned char *,const unsigned char *))
+{
+  int64_t table[64] __attribute__((aligned(32)));
+  long long i,j;
+  unsigned char y[32];
+  unsigned char in[4][32];
+  unsigned char out[4][32];
+  unsigned char want[4][32];
+
+  memcpy(table,inverse256_table_cached(modulus),sizeof table);
+  mpz_set_ui(t_gmp,0);
+  mpz_setbit(t_gmp,542);
+  mpz_mod(t_gmp,t_gmp,p_gmp);
+  for (i = 0;i < 9;++i) {
+    table[27+4*i] = mpz_fdiv_ui(t_gmp,1UL<<30);
+    mpz_fdiv_q_2exp(t_gmp,t_gmp,30);
+  }
+
+  for (i = 0;i < 4000;++i) {
+    mpz_urandomb(x_gmp,batchrand,256);
+    if (i%13 == 0) mpz_set_ui(x_gmp,i);
+    if (i%17 == 0) mpz_mul_ui(x_gmp,p_gmp,i%2);
+    if (i%19 == 0) mpz_sub_ui(x_gmp,p_gmp,i);
+    if (i%23 == 0) mpz_sub_ui(x_gmp,two256_gmp,i+1);
+    assert(gmp_export(x,32,x_gmp) == 0);
+    if (mpz_invert(z_gmp,x_gmp,p_gmp)) {
+      mpz_mul_2exp(z_gmp,z_gmp,512);
+      mpz_mod(z_gmp,z_gmp,p_gmp);
+    } else mpz_set_ui(z_gmp,0);
+    mont(y,x);
+    gmp_import(y_gmp,y,32);
+    assert(mpz_cmp(y_gmp,z_gmp) == 0);
+    inverse256_portable(y,x,table);
+    gmp_import(y_gmp,y,32);
+    assert(mpz_cmp(y_gmp,z_gmp) == 0);
+    inverse256_vartime(y,x,table);
+    gmp_import(y_gmp,y,32);
+    assert(mpz_cmp(y_gmp,z_gmp) == 0);
+    inverse256_vartime_portable(y,x,table);
+    gmp_import(y_gmp,y,32);
+    assert(mpz_cmp(y_gmp,z_gmp) == 0);
+
+    memcpy(in[i%4],x,32);
+    memcpy(want[i%4],y,32);
+    if (i%4 == 3) {
+      inverse256_x4(out,(const unsigned char (*)[32]) in,table);
+      for (j = 0;j < 4;++j) assert(memcmp(out[j],want[j],32) == 0);
+    }
+  }
+}
+
+/* the limb entry points must return what the string one does, in
+   their limb order or radix */
+
+void checklimbs(mpz_t p_gmp,void (*inverse256)(unsigned char *,const unsigned char *),void (*limbs)(uint64_t *,const uint64_t *),void (*limbs_be)(uint64_t *,const uint64_t *),void (*limbs30)(int64_t *,const uint64_t *))
+{
+  uint64_t a[4],b[4],c[4];
+  int64_t r[9];
+  unsigned char y[32];
+  long long i,j,k;
+
+  for (i = 0;i < 4000;++i) {
+    mpz_urandomb(x_gmp,batchrand,256);
+    if (i%13 == 0) mpz_set_ui(x_gmp,i);
+    if (i%17 == 0) mpz_mul_ui(x_gmp,p_gmp,i%2);
+    if (i%19 == 0) mpz_sub_ui(x_gmp,p_gmp,i);
+    if (i%23 == 0) mpz_sub_ui(x_gmp,two256_gmp,i+1);
+    assert(gmp_export(x,32,x_gmp) == 0);
+    inverse256(y,x);
+    for (j = 0;j < 4;++j) {
+      a[j] = 0;
+      for (k = 7;k >= 0;--k) a[j] = (a[j]<<8)|x[8*j+k];
+    }
+    limbs(b,a);
+    for (j = 0;j < 4;++j)
+      for (k = 0;k < 8;++k)
+        assert((unsigned char) (b[j]>>(8*k)) == y[8*j+k]);
+    for (j = 0;j < 4;++j) c[j] = a[3-j];
+    limbs_be(c,c);
+    for (j = 0;j < 4;++j) assert(c[j] == b[3-j]);
+    limbs30(r,a);
+    mpz_set_ui(z_gmp,0);
+    for (j = 8;j >= 0;--j) {
+      assert(r[j] >= 0 && r[j] < (1LL<<30));
+      mpz_mul_2exp(z_gmp,z_gmp,30);
+      mpz_add_ui(z_gmp,z_gmp,r[j]);
+    }
+    gmp_import(y_gmp,y,32);
+    assert(mpz_cmp(y_gmp,z_gmp) == 0);
+  }
+}
+
+/* the deferred context must give the inverse of each element it was
+   handed: in order and out of it, with batches left partial for the
+   deadline to flush, with a full ring, and with callers on several
+   threads, both with and without the worker */
+
+typedef struct {
+  inverse256_ctx *c;
+  const int64_t *table;
+  long long seed;
+} ctxcaller;
+
+static void *ctxcalls(void *arg)
+{
+  ctxcaller *k = arg;
+  unsigned char x[4][32],y[4][32],z[32];
+  long long h[4],i,j,l;
+
+  for (i = 0;i < 300;++i) {
+    for (j = 0;j < 4;++j) {
+      for (l = 0;l < 32;++l) x[j][l] = (k->seed*7919+i*131+j*17+l*l)>>3;
+      x[j][31] &= 0x7f;
+      if ((i+j)%23 == 4) memset(x[j],0,32);
+      h[j] = ctxput(k->c,y[j],x[j],k->table);
+    }
+    for (j = 3;j >= 0;--j) {
+      if (h[j] >= 0) inverse256_ctx_get(k->c,y[j],h[j]);
+      inverse256_batch(z,x[j],1,k->table);
+      assert(memcmp(y[j],z,32) == 0);
+    }
+  }
+  return 0;
+}
+
+void checkctx(const unsigned char *modulus)
+{
+  static const long long deadline[] = { 0, 1000000 } ;
+  const int64_t *table = inverse256_table_cached(modulus);
+  unsigned char in[100][32],want[100][32],y[32];
+  long long h[100],i,m,d,n;
+  ctxcaller k[4];
+  pthread_t id[4];
+
+  for (i = 0;i < 100*32;++i) in[i/32][i%32] = random();
+  memset(in[7],0,32);
+  memcpy(in[50],modulus,32);
+  inverse256_batch(want[0],in[0],100,table);
+
+  for (m = 0;m < 2;++m)
+    for (d = 0;d < 2;++d) {
+      inverse256_ctx *c = inverse256_ctx_new(table,16,deadline[d],m);
+      assert(c);
+
+      /* 40 at a time: two full batches and a partial one */
+      for (n = 0;n < 100;n += 40) {
+        for (i = n;i < n+40 && i < 100;++i) assert((h[i] = inverse256_ctx_put(c,in[i])) >= 0);
+        for (i = n;i < n+40 && i < 100;++i) {
+          inverse256_ctx_get(c,y,h[i]);
+          assert(memcmp(y,want[i],32) == 0);
+        }
       }
-  printf("sorted");
-  for (i = 1;i < 64;++i)
-    printf(" %lld",t[i]);
-  printf("\n");
-  
-  fflush(stdout);
+
+      /* a ring of 64: the 65th put has to wait for a get */
+      for (i = 0;i < 64;++i) assert((h[i] = inverse256_ctx_put(c,in[i])) >= 0);
+      assert(inverse256_ctx_put(c,in[64]) == -1 && errno == EAGAIN);
+      inverse256_ctx_flush(c);
+      for (i = 63;i >= 0;--i) {
+        inverse256_ctx_get(c,y,h[i]);
+        assert(memcmp(y,want[i],32) == 0);
+      }
+
+      for (i = 0;i < 4;++i) {
+        k[i].c = c;
+        k[i].table = table;
+        k[i].seed = i+4*m+8*d;
+        assert(pthread_create(&id[i],0,ctxcalls,&k[i]) == 0);
+      }
+      for (i = 0;i < 4;++i) assert(pthread_join(id[i],0) == 0);
+      inverse256_ctx_free(c);
+    }
+}
+
+/* the sliced batch and normalization must agree with one thread,
+   whatever the cut: sizes around the slice and chunk lengths, and more
+   threads than there are CPUs */
+
+#define THREADED 10001
+
+void checkthreads(const unsigned char *modulus)
+{
+  static const long long counts[] = { 1, 2, 255, 257, 513, 4097, 8193, 10001 } ;
+  static const int threads[] = { 0, 1, 2, 3, 5, 16 } ;
+  static unsigned char in[96*THREADED],want[96*THREADED],out[96*THREADED];
+  const int64_t *table = inverse256_table_cached(modulus);
+  long long c,i,t,n;
+
+  for (i = 0;i < 96*THREADED;++i) in[i] = random();
+  for (i = 0;i < 3*THREADED;++i) {
+    if (i%29 == 2) memset(in+32*i,0,32);
+    if (i%31 == 5) memcpy(in+32*i,modulus,32);
+  }
+  for (c = 0;c < sizeof counts/sizeof counts[0];++c) {
+    n = counts[c];
+    inverse256_batch(want,in,n,table);
+    for (t = 0;t < sizeof threads/sizeof threads[0];++t) {
+      memset(out,0,32*n);
+      inverse256_batch_threads(out,in,n,table,threads[t]);
+      assert(memcmp(out,want,32*n) == 0);
+    }
+    memcpy(want,in,96*n);
+    normalize_jacobian(want,n,table);
+    for (t = 0;t < sizeof threads/sizeof threads[0];++t) {
+      memcpy(out,in,96*n);
+      normalize_jacobian_threads(out,n,table,threads[t]);
+      assert(memcmp(out,want,96*n) == 0);
+    }
+  }
+}
+
+/* normalized points must match gmp, for counts around the chunk size
+   and with points at infinity (Z = 0 or p) and unreduced coordinates
+   mixed in */
+
+void checknormalize(mpz_t p_gmp,void (*normalize)(unsigned char *,long long))
+{
+  static const long long counts[] = { 1, 2, 3, 255, 256, 257, 512, 700 } ;
+  static unsigned char pts[96*700],orig[96*700];
+  long long c,i,j,n;
+
+  for (c = 0;c < sizeof counts/sizeof counts[0];++c) {
+    n = counts[c];
+    for (i = 0;i < 3*n;++i) {
+      mpz_urandomb(x_gmp,batchrand,256);
+      if (i%29 == 2) mpz_set_ui(x_gmp,0);
+      if (i%31 == 5) mpz_set(x_gmp,p_gmp);
+      if (i%37 == 8) mpz_set_ui(x_gmp,1);
+      assert(gmp_export(pts+32*i,32,x_gmp) == 0);
+    }
+    memcpy(orig,pts,96*n);
+    normalize(pts,n);
+    for (i = 0;i < n;++i) {
+      gmp_import(z_gmp,orig+96*i+64,32);
+      if (!mpz_invert(t_gmp,z_gmp,p_gmp)) {
+        for (j = 0;j < 96;++j) assert(pts[96*i+j] == 0);
+        continue;
+      }
+      gmp_import(x_gmp,orig+96*i,32);
+      mpz_mul(x_gmp,x_gmp,t_gmp);
+      mpz_mul(x_gmp,x_gmp,t_gmp);
+      mpz_mod(x_gmp,x_gmp,p_gmp);
+      gmp_import(y_gmp,pts+96*i,32);
+      assert(mpz_cmp(x_gmp,y_gmp) == 0);
+      gmp_import(x_gmp,orig+96*i+32,32);
+      mpz_powm_ui(t_gmp,t_gmp,3,p_gmp);
+      mpz_mul(x_gmp,x_gmp,t_gmp);
+      mpz_mod(x_gmp,x_gmp,p_gmp);
+      gmp_import(y_gmp,pts+96*i+32,32);
+      assert(mpz_cmp(x_gmp,y_gmp) == 0);
+      gmp_import(y_gmp,pts+96*i+64,32);
+      assert(mpz_cmp_ui(y_gmp,1) == 0);
+    }
+  }
+}
+
+/* the streaming tool must match single inversions through both of its
+   input paths: a mapped regular file, and a pipe that delivers the
+   records in pieces that do not line up with them */
+
+#define STREAM 10007
+
+void checkstream(mpz_t p_gmp,const unsigned char *modulus,void (*inverse256)(unsigned char *,const unsigned char *))
+{
+  const int64_t *table = inverse256_table_cached(modulus);
+  static unsigned char in[32*STREAM];
+  static unsigned char out[32*STREAM];
+  unsigned char y[32];
+  FILE *fin,*fout;
+  int fd[2];
+  long long i,w;
+  pid_t pid;
+
+  for (i = 0;i < STREAM;++i) {
+    mpz_urandomb(x_gmp,batchrand,256);
+    if (i%7 == 3) mpz_set_ui(x_gmp,0);
+    if (i%11 == 5) mpz_set(x_gmp,p_gmp);
+    assert(gmp_export(in+32*i,32,x_gmp) == 0);
+  }
+
+  fin = tmpfile();
+  fout = tmpfile();
+  assert(fin && fout);
+  assert(write(fileno(fin),in,sizeof in) == sizeof in);
+  assert(lseek(fileno(fin),0,SEEK_SET) == 0);
+  assert(inverse256_stream(fileno(fin),fileno(fout),table) == STREAM);
+  assert(pread(fileno(fout),out,sizeof out,0) == sizeof out);
+  for (i = 0;i < STREAM;++i) {
+    inverse256(y,in+32*i);
+    assert(memcmp(y,out+32*i,32) == 0);
+  }
+
+  assert(pipe(fd) == 0);
+  pid = fork();
+  assert(pid >= 0);
+  if (pid == 0) {
+    close(fd[0]);
+    for (i = 0;i < sizeof in;i += w) {
+      w = 1000+i%77;
+      if (w > sizeof in-i) w = sizeof in-i;
+      if (write(fd[1],in+i,w) != w) _exit(1);
+    }
+    _exit(0);
+  }
+  close(fd[1]);
+  assert(ftruncate(fileno(fout),0) == 0);
+  assert(lseek(fileno(fout),0,SEEK_SET) == 0);
+  memset(out,0,sizeof out);
+  assert(inverse256_stream(fd[0],fileno(fout),table) == STREAM);
+  close(fd[0]);
+  assert(waitpid(pid,0,0) == pid);
+  assert(pread(fileno(fout),out,sizeof out,0) == sizeof out);
+  for (i = 0;i < STREAM;++i) {
+    inverse256(y,in+32*i);
+    assert(memcmp(y,out+32*i,32) == 0);
+  }
+
+  assert(ftruncate(fileno(fin),32*5+3) == 0);
+  assert(lseek(fileno(fin),0,SEEK_SET) == 0);
+  errno = 0;
+  assert(inverse256_stream(fileno(fin),fileno(fout),table) == -1);
+  assert(errno == EINVAL);
+
+  fclose(fin);
+  fclose(fout);
 }
 
 #define NUMPRIMES 1
 struct {
   const char *name;
   void (*inverse256)(unsigned char *,const unsigned char *);
+  void (*batch)(unsigned char *,const unsigned char *,long long);
+  void (*x4)(unsigned char (*)[32],const unsigned char (*)[32]);
+  void (*vartime)(unsigned char *,const unsigned char *);
+  int (*jacobi)(const unsigned char *);
+  void (*jacobi_batch)(int *,const unsigned char *,long long);
+  int (*jacobi_vartime)(const unsigned char *);
+  void (*mont)(unsigned char *,const unsigned char *);
+  void (*limbs)(uint64_t *,const uint64_t *);
+  void (*limbs_be)(uint64_t *,const uint64_t *);
+  void (*limbs30)(int64_t *,const uint64_t *);
+  void (*normalize)(unsigned char *,long long);
   unsigned char *modulus;
   mpz_t gmp;
 } primes[NUMPRIMES] = {
-  { "P256_p", inverse256_P256_p, inverse256_P256_p_modulus },
+  { "P256_p", inverse256_P256_p, inverse256_P256_p_batch, inverse256_P256_p_x4, inverse256_P256_p_vartime, jacobi256_P256_p, jacobi256_P256_p_batch, jacobi256_P256_p_vartime, inverse256_P256_p_mont, inverse256_P256_p_limbs, inverse256_P256_p_limbs_be, inverse256_P256_p_limbs30, normalize_jacobian_P256_p, inverse256_P256_p_modulus },
 } ;
 
-int main(int argc, char *argv[])
+/* The exhaustive sweeps below are cut into chunks that depend only on
+   their index.  Threads take the next chunk from a shared counter until
+   none are left, so fast threads pick up the slack of slow ones, and
+   the set of inputs checked is the same for any number of threads.
+   TEST_THREADS overrides the thread count (all online CPUs). */
+
+typedef struct {
+  const char *what;
+  long long k;
+  long long chunks;
+  void (*chunk)(long long,long long);
+  long long next;
+  long long done;
+} sweep;
+
+static char *tag = "";
+
+static void *worker(void *arg)
 {
-  long long i,j,k;
+  sweep *s = arg;
+  long long c,d;
+
+  mpz_inits(x_gmp,y_gmp,xy_gmp,z_gmp,twop_gmp,NULL);
+  while ((c = __atomic_fetch_add(&s->next,1,__ATOMIC_RELAXED)) < s->chunks) {
+    s->chunk(s->k,c);
+    d = __atomic_add_fetch(&s->done,1,__ATOMIC_RELAXED);
+    if (d < s->chunks && d*10/s->chunks != (d-1)*10/s->chunks) {
+      printf("%s%s %s: %lld/%lld chunks\n",tag,primes[s->k].name,s->what,d,s->chunks);
+      fflush(stdout);
+    }
+  }
+  mpz_clears(x_gmp,y_gmp,xy_gmp,z_gmp,twop_gmp,NULL);
+  return 0;
+}
+
+static void parallel(const char *what,long long k,long long chunks,void (*chunk)(long long,long long))
+{
+  sweep s = { what, k, chunks, chunk, 0, 0 };
+  pthread_t thread[256];
+  struct timespec t0,t1;
+  long long i,n;
+  char *env = getenv("TEST_THREADS");
+
+  n = env ? atoll(env) : sysconf(_SC_NPROCESSORS_ONLN);
+  if (n < 1) n = 1;
+  if (n > 256) n = 256;
+
+  printf("%s%s checking %s\n",tag,primes[k].name,what);
+  fflush(stdout);
+  clock_gettime(CLOCK_MONOTONIC,&t0);
+  for (i = 0;i < n;++i) assert(pthread_create(&thread[i],0,worker,&s) == 0);
+  for (i = 0;i < n;++i) assert(pthread_join(thread[i],0) == 0);
+  clock_gettime(CLOCK_MONOTONIC,&t1);
+  printf("%s%s %s: %lld chunks in %.2f s on %lld threads\n",tag,primes[k].name,what,chunks,
+    (t1.tv_sec-t0.tv_sec)+(t1.tv_nsec-t0.tv_nsec)*1e-9,n);
+  fflush(stdout);
+}
+
+/* 2000 integers near the modulus, 100 per chunk */
+
+static void nearmodulus(long long k,long long c)
+{
+  unsigned char x[32];
+  long long i;
+
+  for (i = -1000+100*c;i < -900+100*c;++i) {
+    mpz_set_si(x_gmp,i);
+    mpz_add(x_gmp,x_gmp,primes[k].gmp);
+    mpz_mod(x_gmp,x_gmp,primes[k].gmp);
+    assert(gmp_export(x,32,x_gmp) == 0);
+    doit(x,primes[k].gmp,primes[k].modulus,primes[k].inverse256);
+  }
+}
+
+/* 1000 integers below 2^256, 100 per chunk */
+
+static void near2256(long long k,long long c)
+{
+  unsigned char x[32];
+  long long i;
+
+  for (i = -1000+100*c;i < -900+100*c;++i) {
+    mpz_set_si(x_gmp,i);
+    mpz_add(x_gmp,x_gmp,two256_gmp);
+    assert(gmp_export(x,32,x_gmp) == 0);
+    doit(x,primes[k].gmp,primes[k].modulus,primes[k].inverse256);
+  }
+}
+
+/* 2000 integers times 2^c */
+
+static void powers(long long k,long long c)
+{
+  unsigned char x[32];
+  long long i;
+
+  mpz_ui_pow_ui(twop_gmp,2,c);
+  for (i = -1000;i < 1000;++i) {
+    mpz_set_si(x_gmp,i);
+    mpz_mul(x_gmp,x_gmp,twop_gmp);
+    mpz_mod(x_gmp,x_gmp,primes[k].gmp);
+    assert(gmp_export(x,32,x_gmp) == 0);
+    doit(x,primes[k].gmp,primes[k].modulus,primes[k].inverse256);
+  }
+}
 
+/* +-2^a +-2^b +-2^c +-2^d for 63 >= a > b > c > d >= 0, a >= 10, b >= 2;
+   one chunk per (a,b) */
+
+static void hamming(long long k,long long chunk)
+{
+  unsigned char x[32];
   uint64_t tt[2];
-  char *tag = "";
+  int a = 63-chunk/62;
+  int b = 2+chunk%62;
+
+  if (b >= a) return;
+  for (int s_b = -1; s_b <= 1; s_b+=2) {
+    for (int c = b-1; c >= 1; c--) {
+      for (int s_c = -1; s_c <= 1; s_c+=2) {
+        for (int d = c-1; d >= 0; d--) {
+          for (int s_d = -1; s_d <= 1; s_d+=2) {
+            tt[0] = (1ULL<<a)+s_b*(1ULL<<b)+s_c*(1ULL<<c)+s_d*(1ULL<<d);
+            tt[1] = 0; gmp_import(x_gmp,(void*)tt,16);
+            mpz_mod(x_gmp,x_gmp,primes[k].gmp);
+            gmp_export(x,32,x_gmp);
+            doit(x,primes[k].gmp,primes[k].modulus,primes[k].inverse256);
+            mpz_neg(x_gmp,x_gmp);
+            mpz_mod(x_gmp,x_gmp,primes[k].gmp);
+            gmp_export(x,32,x_gmp);
+            doit(x,primes[k].gmp,primes[k].modulus,primes[k].inverse256);
+          }
+        }
+      }
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  long long i,k;
 
   if (argc > 1) tag = argv[1];
+  if (getenv("TEST_GMP")) gmpsample = atoll(getenv("TEST_GMP"));
   
   bench();
+  bench_batch();
+  bench_x4();
+  bench_portable();
+  bench_vartime();
   
   mpz_init(two256_gmp);
   gmp_import(two256_gmp,two256,33);
@@ -236,69 +1427,91 @@ int main(int argc, char *argv[])
   mpz_init(xy_gmp);
   mpz_init(z_gmp);
   mpz_init(twop_gmp);
+  mpz_init(t_gmp);
+
+  bench_jacobi();
+  bench_normalize();
+  bench_threads();
+  bench_ctx();
+
+  for (k = 0;k < NUMPRIMES;++k)
+    parallel("2000 integers near modulus",k,20,nearmodulus);
+
+  for (k = 0;k < NUMPRIMES;++k)
+    parallel("1000 integers near 2^256",k,10,near2256);
 
+  for (k = 0;k < NUMPRIMES;++k)
+    parallel("2000 integers times 256 powers of 2",k,256,powers);
+  
+  gmp_randinit_default(batchrand);
   for (k = 0;k < NUMPRIMES;++k) {
-    printf("%s%s checking 2000 integers near modulus\n",tag,primes[k].name);
-    for (i = -1000;i < 1000;++i) {
-      mpz_set_si(x_gmp,i);
-      mpz_add(x_gmp,x_gmp,primes[k].gmp);
-      mpz_mod(x_gmp,x_gmp,primes[k].gmp);
-      assert(gmp_export(x,32,x_gmp) == 0);
-      doit(x,primes[k].gmp,primes[k].inverse256);
-    }
+    printf("%s%s checking batch inversion against single inversion\n",tag,primes[k].name);
+    checkbatch(primes[k].gmp,primes[k].inverse256,primes[k].batch);
   }
 
   for (k = 0;k < NUMPRIMES;++k) {
-    printf("%s%s checking 1000 integers near 2^256\n",tag,primes[k].name);
-    for (i = -1000;i < 0; ++i) {
-      mpz_set_si(x_gmp,i);
-      mpz_add(x_gmp,x_gmp,two256_gmp);
-      assert(gmp_export(x,32,x_gmp) == 0);
-      doit(x,primes[k].gmp,primes[k].inverse256);
-    }
+    printf("%s%s checking 4-way inversion against single inversion\n",tag,primes[k].name);
+    checkx4(primes[k].gmp,primes[k].inverse256,primes[k].x4);
   }
 
   for (k = 0;k < NUMPRIMES;++k) {
-    printf("%s%s checking 2000 integers times 256 powers of 2\n",tag,primes[k].name);
-    for (j=0; j<256; j++) {
-      mpz_ui_pow_ui(twop_gmp,2,j);
-      for (i = -1000;i < 1000;++i) {
-        mpz_set_si(x_gmp,i);
-        mpz_mul(x_gmp,x_gmp,twop_gmp);
-        mpz_mod(x_gmp,x_gmp,primes[k].gmp);
-        assert(gmp_export(x,32,x_gmp) == 0);
-        doit(x,primes[k].gmp,primes[k].inverse256);
-      }
-    }
+    printf("%s%s checking generated tables\n",tag,primes[k].name);
+    checkgeneric(primes[k].gmp,primes[k].modulus,primes[k].inverse256);
   }
-  
-  for (int a = 63; a >= 10; a--) {
-    for (k = 0;k < NUMPRIMES;++k) {
-      printf("%s%s checking low Hamming weight around 2^%d\n",tag,primes[k].name,a);
-      for (int b = a-1; b >= 2; b--) {
-        for (int s_b = -1; s_b <= 1; s_b+=2) {
-          for (int c = b-1; c >= 1; c--) {
-            for (int s_c = -1; s_c <= 1; s_c+=2) {
-              for (int d = c-1; d >= 0; d--) {
-                for (int s_d = -1; s_d <= 1; s_d+=2) {
-                  tt[0] = (1ULL<<a)+s_b*(1ULL<<b)+s_c*(1ULL<<c)+s_d*(1ULL<<d);
-                  tt[1] = 0; gmp_import(x_gmp,(void*)tt,16);
-                  mpz_mod(x_gmp,x_gmp,primes[k].gmp);
-                  gmp_export(x,32,x_gmp);
-                  doit(x,primes[k].gmp,primes[k].inverse256);
-                  mpz_neg(x_gmp,x_gmp);
-                  mpz_mod(x_gmp,x_gmp,primes[k].gmp);
-                  gmp_export(x,32,x_gmp);
-                  doit(x,primes[k].gmp,primes[k].inverse256);
-                }
-              }
-            }
-          }
-        }
-      }
-    }
+
+  for (k = 0;k < NUMPRIMES;++k) {
+    printf("%s%s checking round counts\n",tag,primes[k].name);
+    checkrounds(primes[k].modulus);
   }
 
+  for (k = 0;k < NUMPRIMES;++k) {
+    printf("%s%s checking portable engine\n",tag,primes[k].name);
+    checkportable(primes[k].gmp,primes[k].modulus,primes[k].inverse256);
+  }
+
+  for (k = 0;k < NUMPRIMES;++k) {
+    printf("%s%s checking variable-time inversion\n",tag,primes[k].name);
+    checkvartime(primes[k].gmp,primes[k].modulus,primes[k].inverse256,primes[k].vartime);
+  }
+
+  for (k = 0;k < NUMPRIMES;++k) {
+    printf("%s%s checking Jacobi symbols\n",tag,primes[k].name);
+    checkjacobi(primes[k].gmp,primes[k].jacobi,primes[k].jacobi_batch,primes[k].jacobi_vartime);
+  }
+
+  for (k = 0;k < NUMPRIMES;++k) {
+    printf("%s%s checking Montgomery-form inversion\n",tag,primes[k].name);
+    checkmont(primes[k].gmp,primes[k].modulus,primes[k].mont);
+  }
+
+  for (k = 0;k < NUMPRIMES;++k) {
+    printf("%s%s checking limb entry points\n",tag,primes[k].name);
+    checklimbs(primes[k].gmp,primes[k].inverse256,primes[k].limbs,primes[k].limbs_be,primes[k].limbs30);
+  }
+
+  for (k = 0;k < NUMPRIMES;++k) {
+    printf("%s%s checking Jacobian normalization\n",tag,primes[k].name);
+    checknormalize(primes[k].gmp,primes[k].normalize);
+  }
+
+  for (k = 0;k < NUMPRIMES;++k) {
+    printf("%s%s checking threaded batches\n",tag,primes[k].name);
+    checkthreads(primes[k].modulus);
+  }
+
+  for (k = 0;k < NUMPRIMES;++k) {
+    printf("%s%s checking deferred inversion\n",tag,primes[k].name);
+    checkctx(primes[k].modulus);
+  }
+
+  for (k = 0;k < NUMPRIMES;++k) {
+    printf("%s%s checking streaming inversion\n",tag,primes[k].name);
+    checkstream(primes[k].gmp,primes[k].modulus,primes[k].inverse256);
+  }
+
+  for (k = 0;k < NUMPRIMES;++k)
+    parallel("low Hamming weight around 2^63..2^10",k,54*62,hamming);
+
   printf("%schecking random integers from stdin\n",tag);
 
     // Start measuring time
@@ -310,7 +1523,7 @@ int main(int argc, char *argv[])
     for (i = 0;i < 32;++i)
       x[i] = getchar();
     for (k = 0;k < NUMPRIMES;++k)
-      doit(x,primes[k].gmp,primes[k].inverse256);
+      doit(x,primes[k].gmp,primes[k].modulus,primes[k].inverse256);
 
 }
     // End measuring time
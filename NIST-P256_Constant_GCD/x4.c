@@ -0,0 +1,302 @@
+#include <string.h>
+#include <stdint.h>
+#include <immintrin.h>
+#include "inverse256.h"
+#include "mont256.h"
+
+/* Four independent inversions modulo the same prime, one per 64-bit
+   lane of a ymm register.
+
+   This is the constant-time safegcd of Bernstein and Yang in the
+   hddivstep form (zeta = -(delta+1/2)), with numbers as 9 signed limbs
+   radix 2^30 like the asm.  There are 22 rounds of 28 divsteps, 616 in
+   all, against the bound of 590 for 256-bit inputs; smaller moduli
+   run enough rounds for the 59 divsteps times the round count at
+   position 61 of the table (0 meaning 10).  Each round builds
+   the 2x2 transition matrix of its divsteps, scales it by 4 so that it
+   is 2^30 times the true matrix, and applies it to [f,g] and [d,e];
+   entries stay below 2^30 in absolute value, which is what lets the
+   products run on vpmuldq.
+
+   A round is two chunks of 14 divsteps.  Within a chunk no shifts of g
+   are done; instead f and the first matrix row are doubled each step,
+   and step i tests bit i of g.  That makes every step linear, so the
+   bottom 14 bits of f and its matrix row share one 64-bit word,
+   f + 2^30 u + 2^47 v, and likewise for g, q, r.  14 is the largest
+   chunk for which the three fields fit.
+
+   Vectors are kept limb-major: limb i of lane j is x[4*i+j].  This is
+   the layout of the ymm rows in the 64-entry table, and it is what
+   inverse256_x4_soa() takes directly; inverse256_x4() converts from
+   and to four 32-byte strings.  e starts from positions 27, 31, ...,
+   59 of the table, as in portable.c, so the _mont tables work too. */
+
+typedef __m256i vec;
+
+#define M30 0x3fffffff
+#define M14 0x3fff
+
+/* Carries between limbs are kept biased by 2^62, which makes them
+   nonnegative (every partial sum is below 2^62 in absolute value), so
+   a logical shift does the work of the arithmetic one AVX2 lacks. */
+#define BIAS ((int64_t) 1<<62)
+#define REBIAS (((int64_t) 1<<62)-((int64_t) 1<<32))
+
+static inline vec sign(vec x)
+{
+  return _mm256_cmpgt_epi64(_mm256_setzero_si256(),x);
+}
+
+/* arithmetic right shift by 30, only used outside the main loop */
+static inline vec sra30(vec x)
+{
+  return _mm256_or_si256(_mm256_srli_epi64(x,30),_mm256_slli_epi64(sign(x),34));
+}
+
+/* signed field at bits 47..63 of x + 2^46, moved to the bottom dword */
+static inline vec top17(vec x)
+{
+  x = _mm256_add_epi64(x,_mm256_set1_epi64x((int64_t) 1<<46));
+  return _mm256_shuffle_epi32(_mm256_srai_epi32(x,15),0xf5);
+}
+
+/* 14 divsteps on the bottom 14 bits of f and g;
+   the matrix comes back scaled by 2^14 in the bottom dwords */
+
+static inline vec divsteps_14(vec zeta,vec f,vec g,vec *u,vec *v,vec *q,vec *r)
+{
+  const vec one = _mm256_set1_epi64x(1);
+  const vec zero = _mm256_setzero_si256();
+  const vec m14 = _mm256_set1_epi64x(M14);
+  vec F,G,m1,m2,x;
+  int i;
+
+  F = _mm256_add_epi64(_mm256_and_si256(f,m14),_mm256_set1_epi64x((int64_t) 1<<30));
+  G = _mm256_add_epi64(_mm256_and_si256(g,m14),_mm256_set1_epi64x((int64_t) 1<<47));
+
+  for (i = 0;i < 14;++i) {
+    m1 = _mm256_srai_epi32(zeta,31);
+    m2 = _mm256_cmpeq_epi64(_mm256_and_si256(G,_mm256_set1_epi64x((int64_t) 1<<i)),zero);
+    x = _mm256_sub_epi64(_mm256_xor_si256(F,m1),m1);
+    m1 = _mm256_andnot_si256(m2,m1);
+    F = _mm256_blendv_epi8(F,G,m1);
+    G = _mm256_add_epi64(G,_mm256_andnot_si256(m2,x));
+    zeta = _mm256_sub_epi64(_mm256_xor_si256(zeta,m1),one);
+    F = _mm256_add_epi64(F,F);
+  }
+
+  *v = top17(F);
+  *u = top17(_mm256_slli_epi64(F,17));
+  *r = top17(G);
+  *q = top17(_mm256_slli_epi64(G,17));
+  return zeta;
+}
+
+/* 28 divsteps; the matrix comes back as full 64-bit lanes scaled by 2^30 */
+
+static inline vec divsteps_28(vec zeta,vec f,vec g,vec *u,vec *v,vec *q,vec *r)
+{
+  vec u1,v1,q1,r1,u2,v2,q2,r2,f1,g1;
+
+  zeta = divsteps_14(zeta,f,g,&u1,&v1,&q1,&r1);
+
+  f1 = _mm256_add_epi64(_mm256_mul_epi32(u1,f),_mm256_mul_epi32(v1,g));
+  g1 = _mm256_add_epi64(_mm256_mul_epi32(q1,f),_mm256_mul_epi32(r1,g));
+  f1 = _mm256_srli_epi64(f1,14);
+  g1 = _mm256_srli_epi64(g1,14);
+
+  zeta = divsteps_14(zeta,f1,g1,&u2,&v2,&q2,&r2);
+
+  *u = _mm256_add_epi64(_mm256_mul_epi32(u2,u1),_mm256_mul_epi32(v2,q1));
+  *v = _mm256_add_epi64(_mm256_mul_epi32(u2,v1),_mm256_mul_epi32(v2,r1));
+  *q = _mm256_add_epi64(_mm256_mul_epi32(q2,u1),_mm256_mul_epi32(r2,q1));
+  *r = _mm256_add_epi64(_mm256_mul_epi32(q2,v1),_mm256_mul_epi32(r2,r1));
+  *u = _mm256_slli_epi64(*u,2);
+  *v = _mm256_slli_epi64(*v,2);
+  *q = _mm256_slli_epi64(*q,2);
+  *r = _mm256_slli_epi64(*r,2);
+  return zeta;
+}
+
+/* [d,e] = (t [d,e] + p [md,me]) / 2^30, md and me chosen to make the
+   division exact and to keep d and e in (-2p,p) */
+
+static inline void update_de(vec *d,vec *e,vec u,vec v,vec q,vec r,const vec *p,vec pinv)
+{
+  const vec m30 = _mm256_set1_epi64x(M30);
+  const vec bias = _mm256_set1_epi64x(BIAS);
+  const vec rebias = _mm256_set1_epi64x(REBIAS);
+  vec sd,se,md,me,cd,ce;
+  int i;
+
+  sd = sign(d[8]);
+  se = sign(e[8]);
+  md = _mm256_add_epi64(_mm256_and_si256(u,sd),_mm256_and_si256(v,se));
+  me = _mm256_add_epi64(_mm256_and_si256(q,sd),_mm256_and_si256(r,se));
+
+  cd = _mm256_add_epi64(_mm256_mul_epi32(u,d[0]),_mm256_mul_epi32(v,e[0]));
+  ce = _mm256_add_epi64(_mm256_mul_epi32(q,d[0]),_mm256_mul_epi32(r,e[0]));
+
+  md = _mm256_sub_epi64(md,_mm256_and_si256(_mm256_add_epi64(_mm256_mul_epu32(pinv,cd),md),m30));
+  me = _mm256_sub_epi64(me,_mm256_and_si256(_mm256_add_epi64(_mm256_mul_epu32(pinv,ce),me),m30));
+
+  cd = _mm256_add_epi64(cd,_mm256_add_epi64(_mm256_mul_epi32(p[0],md),bias));
+  ce = _mm256_add_epi64(ce,_mm256_add_epi64(_mm256_mul_epi32(p[0],me),bias));
+
+  for (i = 1;i < 9;++i) {
+    cd = _mm256_add_epi64(_mm256_srli_epi64(cd,30),rebias);
+    ce = _mm256_add_epi64(_mm256_srli_epi64(ce,30),rebias);
+    cd = _mm256_add_epi64(cd,_mm256_add_epi64(_mm256_mul_epi32(u,d[i]),_mm256_mul_epi32(v,e[i])));
+    ce = _mm256_add_epi64(ce,_mm256_add_epi64(_mm256_mul_epi32(q,d[i]),_mm256_mul_epi32(r,e[i])));
+    cd = _mm256_add_epi64(cd,_mm256_mul_epi32(p[i],md));
+    ce = _mm256_add_epi64(ce,_mm256_mul_epi32(p[i],me));
+    d[i-1] = _mm256_and_si256(cd,m30);
+    e[i-1] = _mm256_and_si256(ce,m30);
+  }
+  d[8] = _mm256_sub_epi64(_mm256_srli_epi64(cd,30),_mm256_set1_epi64x((int64_t) 1<<32));
+  e[8] = _mm256_sub_epi64(_mm256_srli_epi64(ce,30),_mm256_set1_epi64x((int64_t) 1<<32));
+}
+
+/* [f,g] = t [f,g] / 2^30, exact by construction of t */
+
+static inline void update_fg(vec *f,vec *g,vec u,vec v,vec q,vec r)
+{
+  const vec m30 = _mm256_set1_epi64x(M30);
+  const vec bias = _mm256_set1_epi64x(BIAS);
+  const vec rebias = _mm256_set1_epi64x(REBIAS);
+  vec cf,cg;
+  int i;
+
+  cf = _mm256_add_epi64(_mm256_mul_epi32(u,f[0]),_mm256_mul_epi32(v,g[0]));
+  cg = _mm256_add_epi64(_mm256_mul_epi32(q,f[0]),_mm256_mul_epi32(r,g[0]));
+  cf = _mm256_add_epi64(cf,bias);
+  cg = _mm256_add_epi64(cg,bias);
+
+  for (i = 1;i < 9;++i) {
+    cf = _mm256_add_epi64(_mm256_srli_epi64(cf,30),rebias);
+    cg = _mm256_add_epi64(_mm256_srli_epi64(cg,30),rebias);
+    cf = _mm256_add_epi64(cf,_mm256_add_epi64(_mm256_mul_epi32(u,f[i]),_mm256_mul_epi32(v,g[i])));
+    cg = _mm256_add_epi64(cg,_mm256_add_epi64(_mm256_mul_epi32(q,f[i]),_mm256_mul_epi32(r,g[i])));
+    f[i-1] = _mm256_and_si256(cf,m30);
+    g[i-1] = _mm256_and_si256(cg,m30);
+  }
+  f[8] = _mm256_sub_epi64(_mm256_srli_epi64(cf,30),_mm256_set1_epi64x((int64_t) 1<<32));
+  g[8] = _mm256_sub_epi64(_mm256_srli_epi64(cg,30),_mm256_set1_epi64x((int64_t) 1<<32));
+}
+
+/* bottom limbs of t [f,g] / 2^30, enough to start the next divsteps */
+
+static inline void lowlimbs_fg(vec *f0,vec *g0,const vec *f,const vec *g,vec u,vec v,vec q,vec r)
+{
+  const vec m30 = _mm256_set1_epi64x(M30);
+  const vec bias = _mm256_set1_epi64x(BIAS);
+  const vec rebias = _mm256_set1_epi64x(REBIAS);
+  vec cf,cg;
+
+  cf = _mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epi32(u,f[0]),_mm256_mul_epi32(v,g[0])),bias);
+  cg = _mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epi32(q,f[0]),_mm256_mul_epi32(r,g[0])),bias);
+  cf = _mm256_add_epi64(_mm256_srli_epi64(cf,30),rebias);
+  cg = _mm256_add_epi64(_mm256_srli_epi64(cg,30),rebias);
+  cf = _mm256_add_epi64(cf,_mm256_add_epi64(_mm256_mul_epi32(u,f[1]),_mm256_mul_epi32(v,g[1])));
+  cg = _mm256_add_epi64(cg,_mm256_add_epi64(_mm256_mul_epi32(q,f[1]),_mm256_mul_epi32(r,g[1])));
+  *f0 = _mm256_and_si256(cf,m30);
+  *g0 = _mm256_and_si256(cg,m30);
+}
+
+/* d from (-2p,p) to [0,p), negated first where f ended up as -1 */
+
+static inline void normalize(vec *d,vec fsign,const vec *p)
+{
+  const vec m30 = _mm256_set1_epi64x(M30);
+  vec c;
+  int i;
+
+  c = sign(d[8]);
+  for (i = 0;i < 9;++i) d[i] = _mm256_add_epi64(d[i],_mm256_and_si256(p[i],c));
+  for (i = 0;i < 9;++i) d[i] = _mm256_sub_epi64(_mm256_xor_si256(d[i],fsign),fsign);
+  for (i = 0;i < 8;++i) {
+    d[i+1] = _mm256_add_epi64(d[i+1],sra30(d[i]));
+    d[i] = _mm256_and_si256(d[i],m30);
+  }
+
+  c = sign(d[8]);
+  for (i = 0;i < 9;++i) d[i] = _mm256_add_epi64(d[i],_mm256_and_si256(p[i],c));
+  for (i = 0;i < 8;++i) {
+    d[i+1] = _mm256_add_epi64(d[i+1],sra30(d[i]));
+    d[i] = _mm256_and_si256(d[i],m30);
+  }
+}
+
+/* in, out: 9 limbs radix 2^30 for each of 4 lanes, limb-major,
+   0 <= in < p in every lane; out may alias in */
+
+void inverse256_skylake_x4_soa_avx2(int64_t *out,const int64_t *in,const int64_t *table)
+{
+  vec p[9],f[9],g[9],d[9],e[9];
+  vec zeta,u,v,q,r,pinv;
+  vec un,vn,qn,rn,f0,g0;
+  int64_t rounds = (59*(table[61] ? table[61] : 10)+27)/28;
+  int64_t limb;
+  uint64_t a[4];
+  int i,j,k;
+
+  mont256_start(a,table);
+  for (i = 0;i < 9;++i) {
+    k = 30*i;
+    limb = (a[k>>6]>>(k&63))&M30;
+    if ((k&63) > 34 && (k>>6) < 3) limb |= (a[(k>>6)+1]<<(64-(k&63)))&M30;
+    p[i] = _mm256_set1_epi64x(table[24+4*i]);
+    f[i] = p[i];
+    g[i] = _mm256_loadu_si256((const vec *) (in+4*i));
+    d[i] = _mm256_setzero_si256();
+    e[i] = _mm256_set1_epi64x(limb);
+  }
+  pinv = _mm256_set1_epi64x((-table[60])&M30);
+  zeta = _mm256_set1_epi64x(-1);
+
+  /* rounds of 28 divsteps; the divsteps of round j+1 only need the
+     bottom limbs of f, g, so they overlap the updates of round j */
+  zeta = divsteps_28(zeta,f[0],g[0],&u,&v,&q,&r);
+  for (j = 0;j < rounds-1;++j) {
+    lowlimbs_fg(&f0,&g0,f,g,u,v,q,r);
+    zeta = divsteps_28(zeta,f0,g0,&un,&vn,&qn,&rn);
+    update_de(d,e,u,v,q,r,p,pinv);
+    update_fg(f,g,u,v,q,r);
+    u = un; v = vn; q = qn; r = rn;
+  }
+  update_de(d,e,u,v,q,r,p,pinv);
+  update_fg(f,g,u,v,q,r);
+
+  normalize(d,sign(f[8]),p);
+  for (i = 0;i < 9;++i) _mm256_storeu_si256((vec *) (out+4*i),d[i]);
+}
+
+void inverse256_skylake_x4_avx2(unsigned char (*out)[32],const unsigned char (*in)[32],const int64_t *table)
+{
+  int64_t x[36] __attribute__((aligned(32)));
+  uint64_t a[4];
+  int i,j,k;
+
+  for (j = 0;j < 4;++j) {
+    mont256_load(a,in[j],table);
+    for (i = 0;i < 9;++i) {
+      k = 30*i;
+      x[4*i+j] = (a[k>>6]>>(k&63))&M30;
+      if ((k&63) > 34 && (k>>6) < 3)
+        x[4*i+j] |= (a[(k>>6)+1]<<(64-(k&63)))&M30;
+    }
+  }
+
+  inverse256_skylake_x4_soa_avx2(x,x,table);
+
+  for (j = 0;j < 4;++j) {
+    for (i = 0;i < 4;++i) a[i] = 0;
+    for (i = 0;i < 9;++i) {
+      k = 30*i;
+      a[k>>6] |= (uint64_t) x[4*i+j]<<(k&63);
+      if ((k&63) > 34 && (k>>6) < 3)
+        a[(k>>6)+1] |= (uint64_t) x[4*i+j]>>(64-(k&63));
+    }
+    mont256_store(out[j],a);
+  }
+}
@@ -0,0 +1,121 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <cpuid.h>
+#include "inverse256.h"
+#include "mont256.h"
+
+extern void inverse256_skylake_asm(const unsigned char *,unsigned char *,const int64_t *);
+extern void inverse256_skylake_x4_avx2(unsigned char (*)[32],const unsigned char (*)[32],const int64_t *);
+extern void inverse256_skylake_x4_soa_avx2(int64_t *,const int64_t *,const int64_t *);
+
+/* Run-time choice between asm.s and portable.c.
+
+   The asm needs AVX2 and BMI1 (andn), and the OS must save the ymm
+   registers; x4.c needs AVX2.  Everything else in this directory calls
+   the engine through inverse256_skylake_core, which is set once by a
+   constructor before main() runs.  It starts out pointing at the
+   portable code, so callers from other constructors are safe too.
+
+   Setting INVERSE256_PORTABLE in the environment forces the portable
+   path, for testing it on machines that have AVX2. */
+
+static void asm_core(unsigned char *out,const unsigned char *in,const int64_t *table)
+{
+  inverse256_skylake_asm(in,out,table);
+}
+
+void (*inverse256_skylake_core)(unsigned char *,const unsigned char *,const int64_t *) = inverse256_portable;
+static int avx2;
+
+static int cpu_has_avx2(void)
+{
+  unsigned int a,b,c,d;
+  unsigned int lo,hi;
+
+  if (__get_cpuid_max(0,0) < 7) return 0;
+  __cpuid(1,a,b,c,d);
+  if (!(c&bit_OSXSAVE)) return 0;
+  __asm__ volatile("xgetbv" : "=a"(lo),"=d"(hi) : "c"(0));
+  if ((lo&6) != 6) return 0;
+  __cpuid_count(7,0,a,b,c,d);
+  if (!(b&bit_AVX2)) return 0;
+  if (!(b&bit_BMI)) return 0;
+  return 1;
+}
+
+static void __attribute__((constructor)) choose(void)
+{
+  avx2 = cpu_has_avx2() && !getenv("INVERSE256_PORTABLE");
+  inverse256_skylake_core = avx2 ? asm_core : inverse256_portable;
+}
+
+const char *inverse256_implementation(void)
+{
+  return avx2 ? "avx2" : "portable";
+}
+
+/* The asm beats vartime.c on random inputs, so public inputs go to it
+   when it is there, at the cost of inverse256(): it has no early exit.
+   The asm only subtracts p once, which is enough for 2^255 < p;
+   smaller moduli are reduced first, as in inverse256_generic(). */
+
+void inverse256_vartime(unsigned char *out,const unsigned char *in,const int64_t *table)
+{
+  uint64_t x[4];
+  unsigned char s[32];
+
+  if (!avx2) {
+    inverse256_vartime_portable(out,in,table);
+    return;
+  }
+  if (table[23] < 0) {
+    inverse256_skylake_asm(in,out,table);
+    return;
+  }
+  mont256_load(x,in,table);
+  mont256_store(s,x);
+  inverse256_skylake_asm(s,out,table);
+}
+
+/* without AVX2 the 4-way entry points run the lanes one at a time */
+
+void inverse256_x4(unsigned char (*out)[32],const unsigned char (*in)[32],const int64_t *table)
+{
+  int j;
+
+  if (avx2) {
+    inverse256_skylake_x4_avx2(out,in,table);
+    return;
+  }
+  for (j = 0;j < 4;++j) inverse256_portable(out[j],in[j],table);
+}
+
+void inverse256_x4_soa(int64_t *out,const int64_t *in,const int64_t *table)
+{
+  unsigned char s[32];
+  uint64_t a[4];
+  long long i,j,k;
+
+  if (avx2) {
+    inverse256_skylake_x4_soa_avx2(out,in,table);
+    return;
+  }
+  for (j = 0;j < 4;++j) {
+    for (i = 0;i < 4;++i) a[i] = 0;
+    for (i = 0;i < 9;++i) {
+      k = 30*i;
+      a[k>>6] |= (uint64_t) in[4*i+j]<<(k&63);
+      if ((k&63) > 34 && (k>>6) < 3)
+        a[(k>>6)+1] |= (uint64_t) in[4*i+j]>>(64-(k&63));
+    }
+    mont256_store(s,a);
+    inverse256_portable(s,s,table);
+    mont256_load(a,s,table);
+    for (i = 0;i < 9;++i) {
+      k = 30*i;
+      out[4*i+j] = (a[k>>6]>>(k&63))&0x3fffffff;
+      if ((k&63) > 34 && (k>>6) < 3)
+        out[4*i+j] |= (a[(k>>6)+1]<<(64-(k&63)))&0x3fffffff;
+    }
+  }
+}
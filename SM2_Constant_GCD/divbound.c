@@ -0,0 +1,273 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <gmp.h>
+
+/* Certified bounds on the number of hddivsteps (as run by asm.s and
+   portable.c) or divsteps (-d) that take g to 0.
+
+     ./divbound [-d] hex       for f = p, every 0 <= g < p
+     ./divbound [-d] -b bits   for every odd 0 < f < 2^bits, 0 <= g < f
+     ./divbound -t             the round table of generic.c
+
+   The inputs form a convex region: a segment for one modulus, a
+   triangle for all moduli of a size.  After k steps along one sequence
+   of branches, (f_k,g_k) = M (f,g) / 2^k for a fixed integer matrix M,
+   so the inputs taking that sequence land in the image of the region
+   under a linear map, and only integer points of that image occur.
+   Here both branches (g even, g odd) are applied to every image, and
+   the images that reach the same delta are replaced by the convex
+   hull of their union: a superset of what can occur.  A hull with
+   |g| < 1 everywhere holds no integer point but g = 0, so inputs
+   there are done; the count printed is the first k at which every
+   hull is done, and every input in the region has g_k = 0.
+
+   Coordinates are kept as integers times 2^k, so all of this is exact.
+   The 256-bit moduli in table.c come out at 590 hddivsteps, the count
+   asm.s has always run; smaller moduli need fewer, which is what -t
+   tabulates. */
+
+#define MAXSTEPS 2048
+#define DELTAS (4*MAXSTEPS+8)
+
+typedef struct {
+  mpz_t f,g;
+} point;
+
+typedef struct {
+  point *v;
+  long long n,alloc;
+} poly;
+
+static poly cur[DELTAS],next[DELTAS];
+static point **sorted;
+static long long sortedalloc;
+static mpz_t t0,t1,t2,t3;
+
+static point *push(poly *p)
+{
+  long long i;
+
+  if (p->n == p->alloc) {
+    p->alloc = 2*p->alloc+8;
+    p->v = realloc(p->v,p->alloc*sizeof(point));
+    if (!p->v) { perror("divbound"); exit(111); }
+    for (i = p->n;i < p->alloc;++i) mpz_inits(p->v[i].f,p->v[i].g,NULL);
+  }
+  return &p->v[p->n++];
+}
+
+static int cmp(const void *x,const void *y)
+{
+  const point *a = *(const point **) x,*b = *(const point **) y;
+  int c = mpz_cmp(a->f,b->f);
+  return c ? c : mpz_cmp(a->g,b->g);
+}
+
+/* sign of (a-o) x (b-o) */
+
+static int cross(const point *o,const point *a,const point *b)
+{
+  mpz_sub(t0,a->f,o->f);
+  mpz_sub(t1,b->g,o->g);
+  mpz_mul(t2,t0,t1);
+  mpz_sub(t0,a->g,o->g);
+  mpz_sub(t1,b->f,o->f);
+  mpz_mul(t3,t0,t1);
+  return mpz_cmp(t2,t3);
+}
+
+/* replace the points of p by the vertices of their convex hull
+   (Andrew's monotone chain), into q */
+
+static void hull(poly *q,poly *p)
+{
+  long long i,n = 0,lower;
+
+  if (p->n > sortedalloc) {
+    sortedalloc = 2*p->n;
+    sorted = realloc(sorted,sortedalloc*sizeof(point *));
+    if (!sorted) { perror("divbound"); exit(111); }
+  }
+  for (i = 0;i < p->n;++i) sorted[i] = &p->v[i];
+  qsort(sorted,p->n,sizeof(point *),cmp);
+  for (i = 0;i < p->n;++i)
+    if (!n || cmp(&sorted[n-1],&sorted[i])) sorted[n++] = sorted[i];
+
+  q->n = 0;
+  if (n <= 2) {
+    for (i = 0;i < n;++i) {
+      point *r = push(q);
+      mpz_set(r->f,sorted[i]->f);
+      mpz_set(r->g,sorted[i]->g);
+    }
+    return;
+  }
+
+  for (i = 0;i < n;++i) {
+    while (q->n >= 2 && cross(&q->v[q->n-2],&q->v[q->n-1],sorted[i]) <= 0) q->n--;
+    mpz_set(push(q)->f,sorted[i]->f);
+    mpz_set(q->v[q->n-1].g,sorted[i]->g);
+  }
+  lower = q->n;
+  for (i = n-2;i >= 0;--i) {
+    while (q->n > lower && cross(&q->v[q->n-2],&q->v[q->n-1],sorted[i]) <= 0) q->n--;
+    mpz_set(push(q)->f,sorted[i]->f);
+    mpz_set(q->v[q->n-1].g,sorted[i]->g);
+  }
+  q->n--;
+}
+
+/* 2*delta is kept as an index, offset by DELTAS/2 */
+
+static long long bound(const point *region,long long corners,int half)
+{
+  mpz_t limit;
+  long long k,i,j,d,e,active;
+  int done;
+
+  for (i = 0;i < DELTAS;++i) cur[i].n = next[i].n = 0;
+  d = DELTAS/2+(half ? 1 : 2);
+  for (i = 0;i < corners;++i) {
+    point *r = push(&cur[d]);
+    mpz_set(r->f,region[i].f);
+    mpz_set(r->g,region[i].g);
+  }
+  mpz_init_set_ui(limit,1);
+
+  for (k = 0;k < MAXSTEPS;++k) {
+    active = 0;
+    for (i = 0;i < DELTAS;++i) {
+      if (!cur[i].n) continue;
+      done = 1;
+      for (j = 0;j < cur[i].n;++j)
+        if (mpz_cmpabs(cur[i].v[j].g,limit) >= 0) done = 0;
+      if (done) { cur[i].n = 0; continue; }
+      active = 1;
+
+      d = i-DELTAS/2;
+      if (i+2 >= DELTAS || 2-d+DELTAS/2 < 0) { fprintf(stderr,"divbound: more than %d steps\n",MAXSTEPS); exit(111); }
+
+      /* g even: (f,g/2), delta+1 */
+      for (j = 0;j < cur[i].n;++j) {
+        point *r = push(&next[i+2]);
+        mpz_mul_2exp(r->f,cur[i].v[j].f,1);
+        mpz_set(r->g,cur[i].v[j].g);
+      }
+      /* g odd: (g,(g-f)/2), 1-delta if delta > 0; (f,(g+f)/2), delta+1 otherwise */
+      e = d > 0 ? 2-d+DELTAS/2 : i+2;
+      for (j = 0;j < cur[i].n;++j) {
+        point *r = push(&next[e]);
+        if (d > 0) {
+          mpz_mul_2exp(r->f,cur[i].v[j].g,1);
+          mpz_sub(r->g,cur[i].v[j].g,cur[i].v[j].f);
+        } else {
+          mpz_mul_2exp(r->f,cur[i].v[j].f,1);
+          mpz_add(r->g,cur[i].v[j].g,cur[i].v[j].f);
+        }
+      }
+      cur[i].n = 0;
+    }
+    if (!active) break;
+    for (i = 0;i < DELTAS;++i)
+      if (next[i].n) {
+        hull(&cur[i],&next[i]);
+        next[i].n = 0;
+      }
+    mpz_mul_2exp(limit,limit,1);
+  }
+
+  mpz_clear(limit);
+  if (k == MAXSTEPS) { fprintf(stderr,"divbound: more than %d steps\n",MAXSTEPS); exit(111); }
+  return k;
+}
+
+static long long modulus(mpz_t p,int half)
+{
+  point region[2];
+  long long k;
+
+  mpz_init_set(region[0].f,p);
+  mpz_init_set_ui(region[0].g,0);
+  mpz_init_set(region[1].f,p);
+  mpz_init(region[1].g);
+  mpz_sub_ui(region[1].g,p,1);
+  k = bound(region,2,half);
+  mpz_clears(region[0].f,region[0].g,region[1].f,region[1].g,NULL);
+  return k;
+}
+
+static long long bits(long long b,int half)
+{
+  point region[3];
+  long long i,k;
+
+  for (i = 0;i < 3;++i) mpz_inits(region[i].f,region[i].g,NULL);
+  mpz_set_ui(region[0].f,1);
+  mpz_setbit(region[1].f,b);
+  mpz_setbit(region[2].f,b);
+  mpz_setbit(region[2].g,b);
+  k = bound(region,3,half);
+  for (i = 0;i < 3;++i) mpz_clears(region[i].f,region[i].g,NULL);
+  return k;
+}
+
+/* for r = 1..10 rounds of 59 hddivsteps, the largest size of modulus
+   they cover; binary search, since the bound grows with the size */
+
+static void table(void)
+{
+  long long r,lo,hi,mid,prev = 0;
+
+  printf("/* largest size of modulus, in bits, that r rounds of 59 hddivsteps\n");
+  printf("   cover, for r = 0..10; from ./divbound -t */\n\n");
+  printf("static const long long roundbits[11] = {\n  0,");
+  for (r = 1;r <= 10;++r) {
+    lo = prev;
+    hi = 256;
+    while (lo < hi) {
+      mid = (lo+hi+1)/2;
+      if (bits(mid,1) <= 59*r) lo = mid;
+      else hi = mid-1;
+    }
+    printf(" %lld,",lo);
+    fflush(stdout);
+    prev = lo;
+  }
+  printf("\n} ;\n");
+}
+
+int main(int argc,char **argv)
+{
+  int half = 1,opt;
+  long long b = 0;
+  mpz_t p;
+
+  mpz_inits(t0,t1,t2,t3,NULL);
+  while ((opt = getopt(argc,argv,"db:t")) != -1)
+    switch (opt) {
+      case 'd': half = 0; break;
+      case 'b': b = atoll(optarg); break;
+      case 't': table(); return 0;
+      default:
+        fprintf(stderr,"usage: divbound [-d] hex | divbound [-d] -b bits | divbound -t\n");
+        return 100;
+    }
+
+  if (b > 0) {
+    printf("%lld\n",bits(b,half));
+    return 0;
+  }
+  if (optind >= argc) {
+    fprintf(stderr,"usage: divbound [-d] hex | divbound [-d] -b bits | divbound -t\n");
+    return 100;
+  }
+  mpz_init(p);
+  if (mpz_set_str(p,argv[optind],16) != 0 || mpz_even_p(p) || mpz_cmp_ui(p,1) <= 0) {
+    fprintf(stderr,"divbound: %s: not an odd modulus above 1 in hex\n",argv[optind]);
+    return 100;
+  }
+  printf("%lld\n",modulus(p,half));
+  return 0;
+}
@@ -1,18 +1,240 @@
 #ifndef inverse256_h
 #define inverse256_h
 
+#include <stdint.h>
+
 #define inverse256_BTC_p inverse256_skylake_BTC_p
 #define inverse256_BTC_n inverse256_skylake_BTC_n
 #define inverse256_P256_p inverse256_skylake_P256_p
 #define inverse256_P256_n inverse256_skylake_P256_n
 #define inverse256_sm2_p inverse256_skylake_sm2_p
 
+#define inverse256_portable inverse256_skylake_portable
+#define inverse256_implementation inverse256_skylake_implementation
+
+#define inverse256_table_init inverse256_skylake_table_init
+#define inverse256_table_cached inverse256_skylake_table_cached
+#define inverse256_table_builtin inverse256_skylake_table_builtin
+#define inverse256_generic inverse256_skylake_generic
+
+#define inverse256_batch inverse256_skylake_batch
+#define inverse256_BTC_p_batch inverse256_skylake_BTC_p_batch
+#define inverse256_BTC_n_batch inverse256_skylake_BTC_n_batch
+#define inverse256_P256_p_batch inverse256_skylake_P256_p_batch
+#define inverse256_P256_n_batch inverse256_skylake_P256_n_batch
+#define inverse256_sm2_p_batch inverse256_skylake_sm2_p_batch
+
+#define inverse256_stream inverse256_skylake_stream
+
+#define inverse256_batch_threads inverse256_skylake_batch_threads
+#define normalize_jacobian_threads normalize_jacobian_skylake_threads
+
+#define inverse256_ctx_new inverse256_skylake_ctx_new
+#define inverse256_ctx_put inverse256_skylake_ctx_put
+#define inverse256_ctx_get inverse256_skylake_ctx_get
+#define inverse256_ctx_flush inverse256_skylake_ctx_flush
+#define inverse256_ctx_free inverse256_skylake_ctx_free
+
+#define inverse256_vartime inverse256_skylake_vartime
+#define inverse256_vartime_portable inverse256_skylake_vartime_portable
+#define inverse256_BTC_p_vartime inverse256_skylake_BTC_p_vartime
+#define inverse256_BTC_n_vartime inverse256_skylake_BTC_n_vartime
+#define inverse256_P256_p_vartime inverse256_skylake_P256_p_vartime
+#define inverse256_P256_n_vartime inverse256_skylake_P256_n_vartime
+#define inverse256_sm2_p_vartime inverse256_skylake_sm2_p_vartime
+
+#define jacobi256 jacobi256_skylake
+#define jacobi256_batch jacobi256_skylake_batch
+#define jacobi256_vartime jacobi256_skylake_vartime
+#define jacobi256_BTC_p jacobi256_skylake_BTC_p
+#define jacobi256_BTC_n jacobi256_skylake_BTC_n
+#define jacobi256_P256_p jacobi256_skylake_P256_p
+#define jacobi256_P256_n jacobi256_skylake_P256_n
+#define jacobi256_sm2_p jacobi256_skylake_sm2_p
+#define jacobi256_BTC_p_batch jacobi256_skylake_BTC_p_batch
+#define jacobi256_BTC_n_batch jacobi256_skylake_BTC_n_batch
+#define jacobi256_P256_p_batch jacobi256_skylake_P256_p_batch
+#define jacobi256_P256_n_batch jacobi256_skylake_P256_n_batch
+#define jacobi256_sm2_p_batch jacobi256_skylake_sm2_p_batch
+#define jacobi256_BTC_p_vartime jacobi256_skylake_BTC_p_vartime
+#define jacobi256_BTC_n_vartime jacobi256_skylake_BTC_n_vartime
+#define jacobi256_P256_p_vartime jacobi256_skylake_P256_p_vartime
+#define jacobi256_P256_n_vartime jacobi256_skylake_P256_n_vartime
+#define jacobi256_sm2_p_vartime jacobi256_skylake_sm2_p_vartime
+
+#define inverse256_BTC_p_mont inverse256_skylake_BTC_p_mont
+#define inverse256_BTC_n_mont inverse256_skylake_BTC_n_mont
+#define inverse256_P256_p_mont inverse256_skylake_P256_p_mont
+#define inverse256_P256_n_mont inverse256_skylake_P256_n_mont
+#define inverse256_sm2_p_mont inverse256_skylake_sm2_p_mont
+
+#define inverse256_limbs inverse256_skylake_limbs
+#define inverse256_limbs_be inverse256_skylake_limbs_be
+#define inverse256_limbs30 inverse256_skylake_limbs30
+#define inverse256_BTC_p_limbs inverse256_skylake_BTC_p_limbs
+#define inverse256_BTC_p_limbs_be inverse256_skylake_BTC_p_limbs_be
+#define inverse256_BTC_p_limbs30 inverse256_skylake_BTC_p_limbs30
+#define inverse256_BTC_n_limbs inverse256_skylake_BTC_n_limbs
+#define inverse256_BTC_n_limbs_be inverse256_skylake_BTC_n_limbs_be
+#define inverse256_BTC_n_limbs30 inverse256_skylake_BTC_n_limbs30
+#define inverse256_P256_p_limbs inverse256_skylake_P256_p_limbs
+#define inverse256_P256_p_limbs_be inverse256_skylake_P256_p_limbs_be
+#define inverse256_P256_p_limbs30 inverse256_skylake_P256_p_limbs30
+#define inverse256_P256_n_limbs inverse256_skylake_P256_n_limbs
+#define inverse256_P256_n_limbs_be inverse256_skylake_P256_n_limbs_be
+#define inverse256_P256_n_limbs30 inverse256_skylake_P256_n_limbs30
+#define inverse256_sm2_p_limbs inverse256_skylake_sm2_p_limbs
+#define inverse256_sm2_p_limbs_be inverse256_skylake_sm2_p_limbs_be
+#define inverse256_sm2_p_limbs30 inverse256_skylake_sm2_p_limbs30
+
+#define normalize_jacobian normalize_jacobian_skylake
+#define normalize_jacobian_BTC_p normalize_jacobian_skylake_BTC_p
+#define normalize_jacobian_P256_p normalize_jacobian_skylake_P256_p
+#define normalize_jacobian_sm2_p normalize_jacobian_skylake_sm2_p
+
+#define inverse256_x4 inverse256_skylake_x4
+#define inverse256_x4_soa inverse256_skylake_x4_soa
+#define inverse256_BTC_p_x4 inverse256_skylake_BTC_p_x4
+#define inverse256_BTC_n_x4 inverse256_skylake_BTC_n_x4
+#define inverse256_P256_p_x4 inverse256_skylake_P256_p_x4
+#define inverse256_P256_n_x4 inverse256_skylake_P256_n_x4
+#define inverse256_sm2_p_x4 inverse256_skylake_sm2_p_x4
+
 extern void inverse256_BTC_p(unsigned char *,const unsigned char *);
 extern void inverse256_BTC_n(unsigned char *,const unsigned char *);
 extern void inverse256_P256_p(unsigned char *,const unsigned char *);
 extern void inverse256_P256_n(unsigned char *,const unsigned char *);
 extern void inverse256_sm2_p(unsigned char*, const unsigned char*);
 
+/* out = 1/in mod p, 32 bytes little-endian each; any in below 2^256,
+   1/0 = 0.  out may be in.  Constant time unless named _vartime.
+   inverse256_implementation(): the engine in use, "avx2" or "portable" */
+extern const char *inverse256_implementation(void);
+extern void inverse256_portable(unsigned char *,const unsigned char *,const int64_t *);
+
+/* tables for odd moduli 3 <= p < 2^256, 32 bytes little-endian.
+   table_init(table,p) fills 64 int64_t, 0 or -1 on a bad modulus.
+   table_builtin(p): the static table of a modulus above, else 0.
+   table_cached(p): the same, or for other moduli a per-thread slot
+   valid in the calling thread until 8 other moduli are asked for;
+   0 on a bad modulus.  generic(out,in,p): 0 or -1 on a bad modulus */
+extern int inverse256_table_init(int64_t *,const unsigned char *);
+extern const int64_t *inverse256_table_builtin(const unsigned char *);
+extern const int64_t *inverse256_table_cached(const unsigned char *);
+extern int inverse256_generic(unsigned char *,const unsigned char *,const unsigned char *);
+
+/* batch(out,in,n,table): n elements of 32 bytes; out and in must not
+   overlap.  Constant time for a given n */
+extern void inverse256_batch(unsigned char *,const unsigned char *,long long,const int64_t *);
+extern void inverse256_BTC_p_batch(unsigned char *,const unsigned char *,long long);
+extern void inverse256_BTC_n_batch(unsigned char *,const unsigned char *,long long);
+extern void inverse256_P256_p_batch(unsigned char *,const unsigned char *,long long);
+extern void inverse256_P256_n_batch(unsigned char *,const unsigned char *,long long);
+extern void inverse256_sm2_p_batch(unsigned char *,const unsigned char *,long long);
+
+/* stream(infd,outfd,table): 32-byte records in, inverses out; the
+   record count, or -1 on an I/O error or a partial last record (errno
+   EINVAL) */
+extern long long inverse256_stream(int,int,const int64_t *);
+
+/* the batch and normalize_jacobian() split over threads; threads <= 0
+   for one per CPU the process may run on */
+extern void inverse256_batch_threads(unsigned char *,const unsigned char *,long long,const int64_t *,int);
+extern void normalize_jacobian_threads(unsigned char *,long long,const int64_t *,int);
+
+/* ctx_new(table,size,deadline,threaded): batches of up to size, held
+   at most deadline nanoseconds, inverted by a worker thread if
+   threaded, else by the callers in put and get.  put copies in and
+   returns a handle, or -1 with errno EAGAIN while the handle a ring
+   length before it is uncollected; get(ctx,out,handle) waits for the
+   inverse, once per handle.  Thread-safe */
+typedef struct inverse256_ctx inverse256_ctx;
+extern inverse256_ctx *inverse256_ctx_new(const int64_t *,long long,long long,int);
+extern long long inverse256_ctx_put(inverse256_ctx *,const unsigned char *);
+extern void inverse256_ctx_get(inverse256_ctx *,unsigned char *,long long);
+extern void inverse256_ctx_flush(inverse256_ctx *);
+extern void inverse256_ctx_free(inverse256_ctx *);
+
+/* four inversions per call; out may be in.  The soa form takes 9
+   limbs radix 2^30 for 4 lanes, limb-major, each lane below p */
+extern void inverse256_x4(unsigned char (*)[32],const unsigned char (*)[32],const int64_t *);
+extern void inverse256_x4_soa(int64_t *,const int64_t *,const int64_t *);
+extern void inverse256_BTC_p_x4(unsigned char (*)[32],const unsigned char (*)[32]);
+extern void inverse256_BTC_n_x4(unsigned char (*)[32],const unsigned char (*)[32]);
+extern void inverse256_P256_p_x4(unsigned char (*)[32],const unsigned char (*)[32]);
+extern void inverse256_P256_n_x4(unsigned char (*)[32],const unsigned char (*)[32]);
+extern void inverse256_sm2_p_x4(unsigned char (*)[32],const unsigned char (*)[32]);
+
+/* Montgomery form, R = 2^256: aR in, a^-1 R mod p out, 0 for 0; out
+   may be in */
+extern void inverse256_BTC_p_mont(unsigned char *,const unsigned char *);
+extern void inverse256_BTC_n_mont(unsigned char *,const unsigned char *);
+extern void inverse256_P256_p_mont(unsigned char *,const unsigned char *);
+extern void inverse256_P256_n_mont(unsigned char *,const unsigned char *);
+extern void inverse256_sm2_p_mont(unsigned char *,const unsigned char *);
+
+/* the plain inversion on uint64_t[4], least significant limb first;
+   _be, most significant first; limbs30, out as 9 limbs radix 2^30 in
+   int64_t, as inverse256_x4_soa() takes them.  out may be in */
+extern void inverse256_limbs(uint64_t *,const uint64_t *,const int64_t *);
+extern void inverse256_limbs_be(uint64_t *,const uint64_t *,const int64_t *);
+extern void inverse256_limbs30(int64_t *,const uint64_t *,const int64_t *);
+extern void inverse256_BTC_p_limbs(uint64_t *,const uint64_t *);
+extern void inverse256_BTC_p_limbs_be(uint64_t *,const uint64_t *);
+extern void inverse256_BTC_p_limbs30(int64_t *,const uint64_t *);
+extern void inverse256_BTC_n_limbs(uint64_t *,const uint64_t *);
+extern void inverse256_BTC_n_limbs_be(uint64_t *,const uint64_t *);
+extern void inverse256_BTC_n_limbs30(int64_t *,const uint64_t *);
+extern void inverse256_P256_p_limbs(uint64_t *,const uint64_t *);
+extern void inverse256_P256_p_limbs_be(uint64_t *,const uint64_t *);
+extern void inverse256_P256_p_limbs30(int64_t *,const uint64_t *);
+extern void inverse256_P256_n_limbs(uint64_t *,const uint64_t *);
+extern void inverse256_P256_n_limbs_be(uint64_t *,const uint64_t *);
+extern void inverse256_P256_n_limbs30(int64_t *,const uint64_t *);
+extern void inverse256_sm2_p_limbs(uint64_t *,const uint64_t *);
+extern void inverse256_sm2_p_limbs_be(uint64_t *,const uint64_t *);
+extern void inverse256_sm2_p_limbs30(int64_t *,const uint64_t *);
+
+/* n Jacobian points (X:Y:Z), 96 bytes each, to affine in place:
+   X/Z^2, Y/Z^3, Z = 1; the point at infinity (Z = 0) to all zeros.
+   Field primes only.  Constant time for a given n */
+extern void normalize_jacobian(unsigned char *,long long,const int64_t *);
+extern void normalize_jacobian_BTC_p(unsigned char *,long long);
+extern void normalize_jacobian_P256_p(unsigned char *,long long);
+extern void normalize_jacobian_sm2_p(unsigned char *,long long);
+
+/* variable time, for public inputs only; same results as the
+   constant-time functions.  Only faster without AVX2 (see README) */
+extern void inverse256_vartime(unsigned char *,const unsigned char *,const int64_t *);
+extern void inverse256_vartime_portable(unsigned char *,const unsigned char *,const int64_t *);
+extern void inverse256_BTC_p_vartime(unsigned char *,const unsigned char *);
+extern void inverse256_BTC_n_vartime(unsigned char *,const unsigned char *);
+extern void inverse256_P256_p_vartime(unsigned char *,const unsigned char *);
+extern void inverse256_P256_n_vartime(unsigned char *,const unsigned char *);
+extern void inverse256_sm2_p_vartime(unsigned char *,const unsigned char *);
+
+/* Jacobi symbol (x|p): 1, -1, or 0 when x and p share a factor.
+   batch(out,in,n,...): n ints for n inputs of 32 bytes.  Constant
+   time except _vartime, which is for public inputs only */
+extern int jacobi256(const unsigned char *,const int64_t *);
+extern void jacobi256_batch(int *,const unsigned char *,long long,const int64_t *);
+extern int jacobi256_vartime(const unsigned char *,const int64_t *);
+extern int jacobi256_BTC_p(const unsigned char *);
+extern int jacobi256_BTC_n(const unsigned char *);
+extern int jacobi256_P256_p(const unsigned char *);
+extern int jacobi256_P256_n(const unsigned char *);
+extern int jacobi256_sm2_p(const unsigned char *);
+extern void jacobi256_BTC_p_batch(int *,const unsigned char *,long long);
+extern void jacobi256_BTC_n_batch(int *,const unsigned char *,long long);
+extern void jacobi256_P256_p_batch(int *,const unsigned char *,long long);
+extern void jacobi256_P256_n_batch(int *,const unsigned char *,long long);
+extern void jacobi256_sm2_p_batch(int *,const unsigned char *,long long);
+extern int jacobi256_BTC_p_vartime(const unsigned char *);
+extern int jacobi256_BTC_n_vartime(const unsigned char *);
+extern int jacobi256_P256_p_vartime(const unsigned char *);
+extern int jacobi256_P256_n_vartime(const unsigned char *);
+extern int jacobi256_sm2_p_vartime(const unsigned char *);
+
 extern unsigned char inverse256_BTC_p_modulus[32];
 extern unsigned char inverse256_BTC_n_modulus[32];
 extern unsigned char inverse256_P256_p_modulus[32];
@@ -0,0 +1,231 @@
+#include <stdint.h>
+#include "inverse256.h"
+#include "mont256.h"
+
+typedef __int128 int128;
+typedef unsigned __int128 uint128;
+
+/* Jacobi symbol (x|p) for the odd modulus p of a 64-entry inverse256
+   table: 1, -1, or 0 when x and p share a factor.  For a prime p it
+   is the Legendre symbol, the quadratic-residuosity test of point
+   decompression and hash-to-curve, at a fraction of the cost of a
+   Fermat exponentiation.
+
+   Divsteps do not give the symbol directly: the swap step needs
+   quadratic reciprocity, whose sign depends on the signs of f and g,
+   and those are not known from the bottom limbs.  So this is the
+   binary GCD of Pornin ("Optimized Binary GCD for Modular
+   Inversion"), which keeps 0 <= a, 0 < b and subtracts the smaller
+   from the larger: if a is odd, swap when a < b, then a = a-b; then
+   halve a.  Each step shrinks len(a)+len(b) by at least 1, so
+   2 len(p)-1 steps reach a = 0, b = gcd(x,p).  The symbol J = (a|b)
+   follows from bottom bits only: halving a flips it when b = 3 or 5
+   mod 8, a swap of a and b = 3 mod 4 flips it, subtracting b from a
+   keeps it.
+
+   As in the divstep engines, the steps run in rounds on 64-bit
+   values, here approximations of a and b: the bottom 31 bits and the
+   top 33 bits at the length of the larger.  Each round records the
+   transition matrix and applies it to the full a and b, in the limbs
+   radix 2^62 of portable.c.  A comparison can only come out wrong when
+   the top bits of a and b agree, and then a-b is small and negative;
+   the round ends by making a and b nonnegative again, with a flip of
+   J for a negated a when b = 3 mod 4.  In between at most one of a, b
+   is negative (a wrong comparison needs a, b >= 0, and a swap or
+   subtraction with one negative leaves one negative), so reciprocity
+   on two's complement bottom bits still gives the right sign.
+   Pornin's analysis keeps the step count with the approximations; one
+   round of margin is added all the same, since once a = 0 and b = 1
+   further steps change nothing.
+
+   The bottom 31 bits stay exact for 31 steps, minus one per halving;
+   the halving flip needs 3 bits of b, so a round is 29 steps, with
+   the matrix scaled to 2^62 by 2^33.  Everything but the number of
+   rounds, which depends only on the size of p, runs in constant
+   time. */
+
+#define M62 ((int64_t) (UINT64_MAX>>2))
+#define STEPS 29
+
+typedef struct {
+  int64_t u,v,q,r;
+} matrix;
+
+static void to62(int64_t *r,const uint64_t *a)
+{
+  r[0] = a[0]&M62;
+  r[1] = ((a[0]>>62)|(a[1]<<2))&M62;
+  r[2] = ((a[1]>>60)|(a[2]<<4))&M62;
+  r[3] = ((a[2]>>58)|(a[3]<<6))&M62;
+  r[4] = a[3]>>56;
+}
+
+/* [a,b] = t [a,b] / 2^62, exact */
+
+static void update(int64_t *a,int64_t *b,const matrix *t)
+{
+  int128 ca,cb;
+  int i;
+
+  ca = (int128) t->u*a[0]+(int128) t->v*b[0];
+  cb = (int128) t->q*a[0]+(int128) t->r*b[0];
+  ca >>= 62;
+  cb >>= 62;
+  for (i = 1;i < 5;++i) {
+    ca += (int128) t->u*a[i]+(int128) t->v*b[i];
+    cb += (int128) t->q*a[i]+(int128) t->r*b[i];
+    a[i-1] = (int64_t) ca&M62;
+    b[i-1] = (int64_t) cb&M62;
+    ca >>= 62;
+    cb >>= 62;
+  }
+  a[4] = ca;
+  b[4] = cb;
+}
+
+/* r = -r if mask, else r */
+
+static void negate(int64_t *r,int64_t mask)
+{
+  int i;
+
+  for (i = 0;i < 5;++i) r[i] = (r[i]^mask)-mask;
+  for (i = 0;i < 4;++i) {
+    r[i+1] += r[i]>>62;
+    r[i] &= M62;
+  }
+}
+
+/* bits [w,w+33) of r, for 0 <= w < 5*62-33 */
+
+static uint64_t window(const int64_t *r,int64_t w)
+{
+  int64_t k = w/62,s = w%62;
+  uint64_t lo = 0,hi = 0,mask;
+  int i;
+
+  for (i = 0;i < 5;++i) {
+    mask = -(uint64_t) (i == k);
+    lo |= r[i]&mask;
+    hi |= (i < 4 ? r[i+1] : 0)&mask;
+  }
+  return ((lo>>s)|(hi<<1<<(61-s)))&((1ULL<<33)-1);
+}
+
+/* a, b in [0,2^256) to their 64-bit approximations */
+
+static void approx(uint64_t *xa,uint64_t *xb,const int64_t *a,const int64_t *b)
+{
+  int64_t n = 0,w,nz;
+  int i;
+
+  for (i = 0;i < 5;++i) {
+    uint64_t c = a[i]|b[i];
+    nz = -(int64_t) (c != 0);
+    n ^= (n^(62*i+64-__builtin_clzll(c|1)))&nz;
+  }
+  w = n-64;
+  n -= w&(w>>63);
+  *xa = (a[0]&0x7fffffff)|(window(a,n-33)<<31);
+  *xb = (b[0]&0x7fffffff)|(window(b,n-33)<<31);
+}
+
+/* STEPS steps on the approximations; t scaled to 2^62.  The matrix
+   rows are packed two to a word, f + 2^32 g, as the entries stay
+   below 2^29 in absolute value */
+
+static uint64_t steps(uint64_t xa,uint64_t xb,matrix *t,uint64_t j)
+{
+  uint64_t fg0 = 1,fg1 = (uint64_t) 1<<32;
+  uint64_t odd,swap,x;
+  uint128 d;
+  int64_t f;
+  int i;
+
+  for (i = 0;i < STEPS;++i) {
+    odd = -(xa&1);
+    d = (uint128) xa-xb;
+    swap = odd&(uint64_t) (d>>64);
+    j ^= swap&xa&xb&2;
+    xb ^= swap&(xa^xb);
+    xa = (xa&~odd)|((((uint64_t) d^swap)-swap)&odd);
+    x = swap&(fg0^fg1); fg0 ^= x; fg1 ^= x;
+    fg0 -= odd&fg1;
+    xa >>= 1;
+    fg1 <<= 1;
+    j ^= (xb^(xb>>1))&2;
+  }
+  f = (int64_t) (fg0<<32)>>32;
+  t->u = (uint64_t) f<<(62-STEPS);
+  t->v = (uint64_t) (((int64_t) (fg0-f))>>32)<<(62-STEPS);
+  f = (int64_t) (fg1<<32)>>32;
+  t->q = (uint64_t) f<<(62-STEPS);
+  t->r = (uint64_t) (((int64_t) (fg1-f))>>32)<<(62-STEPS);
+  return j;
+}
+
+/* 2 len(p)-1 steps, and a round of margin */
+
+static long long rounds(const int64_t *table)
+{
+  const uint64_t *p = (const uint64_t *) (table+20);
+  long long bits;
+
+  for (bits = 256;bits > 1;--bits)
+    if ((p[(bits-1)>>6]>>((bits-1)&63))&1) break;
+  return (2*bits-1+STEPS-1)/STEPS+1;
+}
+
+static int finish(const int64_t *b,uint64_t j)
+{
+  int64_t one = (b[0]^1)|b[1]|b[2]|b[3]|b[4];
+
+  one = ((one|-one)>>63)+1;
+  return one*(1-(int) (j&2));
+}
+
+static int run(const unsigned char *in,const int64_t *table,int vartime)
+{
+  int64_t a[5],b[5],s;
+  uint64_t x[4],xa,xb,j = 0;
+  matrix t;
+  long long i,n = rounds(table);
+
+  mont256_load(x,in,table);
+  to62(a,x);
+  to62(b,(const uint64_t *) (table+20));
+
+  for (i = 0;i < n;++i) {
+    if (vartime && !(a[0]|a[1]|a[2]|a[3]|a[4])) break;
+    approx(&xa,&xb,a,b);
+    j = steps(xa,xb,&t,j);
+    update(a,b,&t);
+    negate(b,b[4]>>63);
+    s = a[4]>>63;
+    j ^= s&b[0]&2;
+    negate(a,s);
+  }
+  return finish(b,j);
+}
+
+int jacobi256(const unsigned char *in,const int64_t *table)
+{
+  return run(in,table,0);
+}
+
+/* early exit once a = 0: for public inputs only */
+
+int jacobi256_vartime(const unsigned char *in,const int64_t *table)
+{
+  return run(in,table,1);
+}
+
+/* A convenience loop over n inputs: unlike inverse256_batch() there is
+   no shared work, and each symbol costs what jacobi256() does. */
+
+void jacobi256_batch(int *out,const unsigned char *in,long long n,const int64_t *table)
+{
+  long long i;
+
+  for (i = 0;i < n;++i) out[i] = run(in+32*i,table,0);
+}
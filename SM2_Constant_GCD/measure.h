@@ -0,0 +1,33 @@
+#ifndef measure_h
+#define measure_h
+
+/* Cycle measurement for the benchmarks.  measure_init() picks a CPU,
+   opens a perf_event group (cycles, instructions, branch misses) read
+   in user space with rdpmc, and times an empty call to learn the
+   overhead of a sample.  measure() then runs the function
+   warmup+samples times, pinned to that CPU for the run only, and
+   reports per-operation figures with that overhead taken off.  Without
+   perf_event, cycles come from rdtsc and the other two counters read
+   as -1. */
+
+typedef struct {
+  long long warmup;    /* calls discarded before sampling */
+  long long samples;
+  int cpu;             /* pin here; < 0 pins to the current CPU */
+} measure_config;
+
+typedef struct {
+  long long samples;
+  double min,median,p90,p99,mean;
+  double lo,hi;        /* 95% confidence interval of the median */
+  double instructions; /* medians per operation, or -1 */
+  double branchmisses;
+} measure_result;
+
+extern int measure_init(const measure_config *);
+extern int measure(measure_result *,void (*)(void *),void *,long long);
+extern void measure_print(const char *,const measure_result *);
+extern long long measure_overhead(void);
+extern long long cpucycles(void);
+
+#endif
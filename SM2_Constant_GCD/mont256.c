@@ -0,0 +1,156 @@
+#include <stdint.h>
+#include "mont256.h"
+
+typedef unsigned __int128 uint128;
+
+/* h = s mod p, s a 32-byte little-endian string.
+   For the 256-bit primes in table.c one conditional subtraction is
+   enough; smaller moduli take one conditional subtraction of p*2^k per
+   bit of slack, which depends only on p. */
+
+void mont256_load(uint64_t *h,const unsigned char *s,const int64_t *table)
+{
+  const uint64_t *p = (const uint64_t *) (table+20);
+  uint64_t q[4],r[4];
+  uint64_t borrow,mask;
+  uint128 d;
+  long long i,k,bits;
+
+  for (i = 0;i < 4;++i) {
+    h[i] = 0;
+    for (k = 7;k >= 0;--k) h[i] = (h[i]<<8)|s[8*i+k];
+  }
+
+  for (bits = 256;bits > 1;--bits)
+    if ((p[(bits-1)>>6]>>((bits-1)&63))&1) break;
+
+  for (k = 256-bits;k >= 0;--k) {
+    for (i = 0;i < 4;++i) {
+      q[i] = 0;
+      if (i >= (k>>6)) q[i] = p[i-(k>>6)]<<(k&63);
+      if (i > (k>>6) && (k&63)) q[i] |= p[i-(k>>6)-1]>>(64-(k&63));
+    }
+    borrow = 0;
+    for (i = 0;i < 4;++i) {
+      d = (uint128) h[i] - q[i] - borrow;
+      r[i] = (uint64_t) d;
+      borrow = (uint64_t) (d>>64)&1;
+    }
+    mask = borrow-1;
+    for (i = 0;i < 4;++i) h[i] ^= mask&(h[i]^r[i]);
+  }
+}
+
+void mont256_store(unsigned char *s,const uint64_t *h)
+{
+  long long i,k;
+
+  for (i = 0;i < 4;++i)
+    for (k = 0;k < 8;++k)
+      s[8*i+k] = h[i]>>(8*k);
+}
+
+/* e = E/2^30 mod p for the 9 limbs radix 2^30 of E < p at positions
+   27, 31, ..., 59, which the asm starts e from; 1 for the plain
+   tables.  Adding the multiple of p that clears the bottom 30 bits
+   makes the division exact, and leaves e below p + p/2^30, so one
+   conditional subtraction brings it under p */
+
+void mont256_start(uint64_t *e,const int64_t *table)
+{
+  const uint64_t *p = (const uint64_t *) (table+20);
+  uint64_t a[5] = {0,0,0,0,0};
+  uint64_t r[4];
+  uint64_t m,c,borrow,mask;
+  uint128 uv;
+  long long i,k;
+
+  for (i = 0;i < 9;++i) {
+    k = 30*i;
+    a[k>>6] |= (uint64_t) table[27+4*i]<<(k&63);
+    if ((k&63) > 34) a[(k>>6)+1] |= (uint64_t) table[27+4*i]>>(64-(k&63));
+  }
+
+  m = (a[0]*(uint64_t) table[60])&0x3fffffff;
+  c = 0;
+  for (i = 0;i < 4;++i) {
+    uv = (uint128) m*p[i] + a[i] + c;
+    a[i] = (uint64_t) uv;
+    c = uv>>64;
+  }
+  a[4] += c;
+  for (i = 0;i < 4;++i) a[i] = (a[i]>>30)|(a[i+1]<<34);
+  a[4] >>= 30;
+
+  borrow = 0;
+  for (i = 0;i < 4;++i) {
+    uv = (uint128) a[i] - p[i] - borrow;
+    r[i] = (uint64_t) uv;
+    borrow = (uint64_t) (uv>>64)&1;
+  }
+  uv = (uint128) a[4] - borrow;
+  mask = ((uint64_t) (uv>>64)&1)-1;
+  for (i = 0;i < 4;++i) e[i] = a[i]^(mask&(a[i]^r[i]));
+}
+
+/* h = f*g/2^256 mod p; h may alias f or g */
+
+void mont256_mul(uint64_t *h,const uint64_t *f,const uint64_t *g,const int64_t *table)
+{
+  const uint64_t *p = (const uint64_t *) (table+20);
+  uint64_t pinv = table[60];
+  uint64_t t[6] = {0,0,0,0,0,0};
+  uint64_t r[4];
+  uint64_t c,m,borrow,mask;
+  uint128 uv;
+  long long i,j;
+
+  for (i = 0;i < 4;++i) {
+    c = 0;
+    for (j = 0;j < 4;++j) {
+      uv = (uint128) f[j]*g[i] + t[j] + c;
+      t[j] = (uint64_t) uv;
+      c = uv>>64;
+    }
+    uv = (uint128) t[4] + c;
+    t[4] = (uint64_t) uv;
+    t[5] = uv>>64;
+
+    m = t[0]*pinv;
+    uv = (uint128) m*p[0] + t[0];
+    c = uv>>64;
+    for (j = 1;j < 4;++j) {
+      uv = (uint128) m*p[j] + t[j] + c;
+      t[j-1] = (uint64_t) uv;
+      c = uv>>64;
+    }
+    uv = (uint128) t[4] + c;
+    t[3] = (uint64_t) uv;
+    t[4] = t[5]+(uint64_t) (uv>>64);
+  }
+
+  borrow = 0;
+  for (i = 0;i < 4;++i) {
+    uv = (uint128) t[i] - p[i] - borrow;
+    r[i] = (uint64_t) uv;
+    borrow = (uint64_t) (uv>>64)&1;
+  }
+  uv = (uint128) t[4] - borrow;
+  mask = ((uint64_t) (uv>>64)&1)-1;
+  for (i = 0;i < 4;++i) h[i] = t[i]^(mask&(t[i]^r[i]));
+}
+
+/* all-ones if f is zero, else 0 */
+
+uint64_t mont256_iszero(const uint64_t *f)
+{
+  uint64_t z = f[0]|f[1]|f[2]|f[3];
+  return ((z|-z)>>63)-1;
+}
+
+void mont256_cmov(uint64_t *h,const uint64_t *f,uint64_t mask)
+{
+  long long i;
+
+  for (i = 0;i < 4;++i) h[i] ^= mask&(h[i]^f[i]);
+}
@@ -0,0 +1,100 @@
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "inverse256.h"
+
+/* Bulk inversion of 32-byte little-endian records: read from fdin,
+   inverted CHUNK at a time by inverse256_batch(), written to fdout in
+   the same order.  A regular input file is mapped whole and read
+   straight from the mapping; anything else (pipes, sockets, terminals)
+   goes through one large read() buffer, refilled as records are used.
+   Returns the number of records, or -1 with errno set on an I/O error
+   or when the input ends inside a record (EINVAL); records before that
+   point have been written. */
+
+#define CHUNK 4096
+
+static __thread unsigned char inbuf[32*CHUNK];
+static __thread unsigned char outbuf[32*CHUNK];
+
+static int writeall(int fd,const unsigned char *s,long long len)
+{
+  long long w;
+
+  while (len > 0) {
+    w = write(fd,s,len);
+    if (w < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    s += w;
+    len -= w;
+  }
+  return 0;
+}
+
+static long long mapped(int fdin,int fdout,long long len,const int64_t *table)
+{
+  const unsigned char *in;
+  long long n,done;
+
+  in = mmap(0,len,PROT_READ,MAP_PRIVATE,fdin,0);
+  if (in == MAP_FAILED) return -2;
+  madvise((void *) in,len,MADV_SEQUENTIAL);
+
+  for (done = 0;done < len/32;done += n) {
+    n = len/32-done;
+    if (n > CHUNK) n = CHUNK;
+    inverse256_batch(outbuf,in+32*done,n,table);
+    if (writeall(fdout,outbuf,32*n) != 0) {
+      munmap((void *) in,len);
+      return -1;
+    }
+  }
+
+  munmap((void *) in,len);
+  if (len%32) {
+    errno = EINVAL;
+    return -1;
+  }
+  return done;
+}
+
+long long inverse256_stream(int fdin,int fdout,const int64_t *table)
+{
+  struct stat st;
+  long long have = 0,done = 0,r,n;
+
+  if (fstat(fdin,&st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 && lseek(fdin,0,SEEK_CUR) == 0) {
+    r = mapped(fdin,fdout,st.st_size,table);
+    if (r != -2) return r;
+  }
+
+  for (;;) {
+    r = read(fdin,inbuf+have,sizeof inbuf-have);
+    if (r < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    have += r;
+    if (r > 0 && have < sizeof inbuf) continue;
+
+    n = have/32;
+    inverse256_batch(outbuf,inbuf,n,table);
+    if (writeall(fdout,outbuf,32*n) != 0) return -1;
+    done += n;
+    memmove(inbuf,inbuf+32*n,have-32*n);
+    have -= 32*n;
+
+    if (r == 0) break;
+  }
+
+  if (have) {
+    errno = EINVAL;
+    return -1;
+  }
+  return done;
+}
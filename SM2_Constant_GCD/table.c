@@ -1,7 +1,8 @@
+#include <string.h>
 #include <stdint.h>
 #include "inverse256.h"
 
-extern void inverse256_skylake_asm(const unsigned char *,unsigned char *,const int64_t *);
+extern void (*inverse256_skylake_core)(unsigned char *,const unsigned char *,const int64_t *);
 
 /* To set up the table for an arbitrary prime of size 256 or less 
    Copy the first 20 entries of the table verbatim, these are the
@@ -10,10 +11,22 @@ extern void inverse256_skylake_asm(const unsigned char *,unsigned char *,const i
    compute the prime radix 2^64, and enter in positions 20..23.
 
    compute the prime radix 2^30, and enter the 9 limbs in positions
-   24, 28, ... 56; finally, replace position 60 with 1/p mod 2^30.
+   24, 28, ... 56; set position 31 to 1, which makes 2^30 in the
+   limbs radix 2^30 at positions 27, 31, ... 59: the starting value of
+   e, times 2^30 (the result is this value over 2^30 times 1/x, so the
+   _mont tables put 2^542 mod p there and map aR to 1/a R for R =
+   2^256, at no extra cost); replace position 60 with
+   -1/p mod 2^64; finally, set position 61 to the number of rounds of
+   59 divsteps, 0 meaning 10, the count for 256 bits.
+
+   "make divbound; ./divbound <hex>" certifies the number of divsteps
+   a given modulus needs; for the moduli below it is 590, 10 rounds.
+   Smaller moduli need fewer, see roundbits[] in generic.c.
 
    Note: the prime expansion needs all limbs between 0 and 2^30.
 
+   inverse256_table_init() in generic.c does all of this at run time.
+
    We can write a specific multiplication and reduction routine for
    the Bitcoin prime because it is so sparse, but the difference in
    the timings for the 25519 prime and for this routine is about 5%
@@ -45,7 +58,7 @@ int64_t sm2_prime[64] = {
     0x03fffffffLL, 0LL, 0LL, 0LL,
     0x03fffbfffLL, 0LL, 0LL, 0LL,
     0x00000ffffLL, 0LL, 0LL, 0LL,
-    0x0000000000000001ULL, 0LL, 0LL, 0LL };
+    0x0000000000000001ULL, 10LL, 0LL, 0LL };
 
 unsigned char inverse256_sm2_p_modulus[32] = {
   0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
@@ -56,7 +69,86 @@ unsigned char inverse256_sm2_p_modulus[32] = {
 
 void inverse256_sm2_p(unsigned char* out, const unsigned char* in)
 {
-    inverse256_skylake_asm(in, out, sm2_prime);
+    inverse256_skylake_core(out, in, sm2_prime);
+}
+
+void inverse256_sm2_p_batch(unsigned char *out,const unsigned char *in,long long n)
+{
+  inverse256_batch(out,in,n,sm2_prime);
+}
+
+void inverse256_sm2_p_x4(unsigned char (*out)[32],const unsigned char (*in)[32])
+{
+  inverse256_x4(out,in,sm2_prime);
+}
+
+void inverse256_sm2_p_vartime(unsigned char *out,const unsigned char *in)
+{
+  inverse256_vartime(out,in,sm2_prime);
+}
+
+void inverse256_sm2_p_limbs(uint64_t *out,const uint64_t *in)
+{
+  inverse256_limbs(out,in,sm2_prime);
+}
+
+void inverse256_sm2_p_limbs_be(uint64_t *out,const uint64_t *in)
+{
+  inverse256_limbs_be(out,in,sm2_prime);
+}
+
+void inverse256_sm2_p_limbs30(int64_t *out,const uint64_t *in)
+{
+  inverse256_limbs30(out,in,sm2_prime);
+}
+
+void normalize_jacobian_sm2_p(unsigned char *points,long long n)
+{
+  normalize_jacobian(points,n,sm2_prime);
+}
+
+int jacobi256_sm2_p(const unsigned char *in)
+{
+  return jacobi256(in,sm2_prime);
+}
+
+void jacobi256_sm2_p_batch(int *out,const unsigned char *in,long long n)
+{
+  jacobi256_batch(out,in,n,sm2_prime);
+}
+
+int jacobi256_sm2_p_vartime(const unsigned char *in)
+{
+  return jacobi256_vartime(in,sm2_prime);
+}
+
+/* the same with 2^542 mod p as the starting e, for Montgomery-form
+   input and output */
+static const __attribute__((aligned(32)))
+int64_t sm2_prime_mont[64] = {
+    0x3FFFFFFFLL, 0x3FFFFFFFLL, 0x3FFFFFFFLL, 0x3FFFFFFFLL,
+    0x200000000LL, 0x200000000LL, 0x200000000LL, 0x200000000LL,
+    0x8000000000000000LL, 0x8000000000000000LL,
+    0x8000000000000000LL, 0x8000000000000000LL,
+    0X7FFFFFFE00000000LL, 0X7FFFFFFE00000000LL,
+    0X7FFFFFFE00000000LL, 0X7FFFFFFE00000000LL,
+    0x20000000LL, 0x20000000LL, 0x20000000LL, 0x20000000LL,
+    0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFF00000000ULL,
+    0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFEFFFFFFFFULL,
+    0x03fffffffLL, 0LL, 0LL, 0x00000001LL,
+    0x03fffffffLL, 0LL, 0LL, 0x00000003LL,
+    0x00000000fLL, 0LL, 0LL, 0x3ffffff8LL,
+    0x03fffffc0LL, 0LL, 0LL, 0x0000002fLL,
+    0x03fffffffLL, 0LL, 0LL, 0x000000c0LL,
+    0x03fffffffLL, 0LL, 0LL, 0x00000100LL,
+    0x03fffffffLL, 0LL, 0LL, 0x00000400LL,
+    0x03fffbfffLL, 0LL, 0LL, 0x00006000LL,
+    0x00000ffffLL, 0LL, 0LL, 0x00000000LL,
+    0x0000000000000001ULL, 10LL, 0LL, 0LL };
+
+void inverse256_sm2_p_mont(unsigned char *out,const unsigned char *in)
+{
+  inverse256_skylake_core(out,in,sm2_prime_mont);
 }
 
 
@@ -84,7 +176,7 @@ int64_t t_BTC_p[64]={
     0x03fffffffLL, 0LL, 0LL, 0LL,
     0x03fffffffLL, 0LL, 0LL, 0LL,
     0x00000ffffLL, 0LL, 0LL, 0LL,
-    0xd838091dd2253531ULL, 0LL, 0LL, 0LL};
+    0xd838091dd2253531ULL, 10LL, 0LL, 0LL};
 
 unsigned char inverse256_BTC_p_modulus[32] = {
   0x2f,0xfc,0xff,0xff,0xfe,0xff,0xff,0xff,
@@ -95,7 +187,86 @@ unsigned char inverse256_BTC_p_modulus[32] = {
 
 void inverse256_BTC_p(unsigned char *out,const unsigned char *in)
 {
-  inverse256_skylake_asm(in,out,t_BTC_p);
+  inverse256_skylake_core(out,in,t_BTC_p);
+}
+
+void inverse256_BTC_p_batch(unsigned char *out,const unsigned char *in,long long n)
+{
+  inverse256_batch(out,in,n,t_BTC_p);
+}
+
+void inverse256_BTC_p_x4(unsigned char (*out)[32],const unsigned char (*in)[32])
+{
+  inverse256_x4(out,in,t_BTC_p);
+}
+
+void inverse256_BTC_p_vartime(unsigned char *out,const unsigned char *in)
+{
+  inverse256_vartime(out,in,t_BTC_p);
+}
+
+void inverse256_BTC_p_limbs(uint64_t *out,const uint64_t *in)
+{
+  inverse256_limbs(out,in,t_BTC_p);
+}
+
+void inverse256_BTC_p_limbs_be(uint64_t *out,const uint64_t *in)
+{
+  inverse256_limbs_be(out,in,t_BTC_p);
+}
+
+void inverse256_BTC_p_limbs30(int64_t *out,const uint64_t *in)
+{
+  inverse256_limbs30(out,in,t_BTC_p);
+}
+
+void normalize_jacobian_BTC_p(unsigned char *points,long long n)
+{
+  normalize_jacobian(points,n,t_BTC_p);
+}
+
+int jacobi256_BTC_p(const unsigned char *in)
+{
+  return jacobi256(in,t_BTC_p);
+}
+
+void jacobi256_BTC_p_batch(int *out,const unsigned char *in,long long n)
+{
+  jacobi256_batch(out,in,n,t_BTC_p);
+}
+
+int jacobi256_BTC_p_vartime(const unsigned char *in)
+{
+  return jacobi256_vartime(in,t_BTC_p);
+}
+
+/* the same with 2^542 mod p as the starting e, for Montgomery-form
+   input and output */
+static const __attribute__((aligned(32)))
+int64_t t_BTC_p_mont[64] = {
+    0x3FFFFFFFLL, 0x3FFFFFFFLL, 0x3FFFFFFFLL, 0x3FFFFFFFLL,
+    0x200000000LL, 0x200000000LL, 0x200000000LL, 0x200000000LL,
+    0x8000000000000000LL, 0x8000000000000000LL,
+    0x8000000000000000LL, 0x8000000000000000LL,
+    0X7FFFFFFE00000000LL, 0X7FFFFFFE00000000LL,
+    0X7FFFFFFE00000000LL, 0X7FFFFFFE00000000LL,
+    0x20000000LL, 0x20000000LL, 0x20000000LL, 0x20000000LL,
+    0xfffffffefffffc2fULL, 0xffffffffffffffffULL,
+    0xffffffffffffffffULL, 0xffffffffffffffffULL,
+    0x03ffffc2fLL, 0LL, 0LL, 0x00000000LL,
+    0x03ffffffbLL, 0LL, 0LL, 0x000e90a1LL,
+    0x03fffffffLL, 0LL, 0LL, 0x00001e88LL,
+    0x03fffffffLL, 0LL, 0LL, 0x00000010LL,
+    0x03fffffffLL, 0LL, 0LL, 0x00000000LL,
+    0x03fffffffLL, 0LL, 0LL, 0x00000000LL,
+    0x03fffffffLL, 0LL, 0LL, 0x00000000LL,
+    0x03fffffffLL, 0LL, 0LL, 0x00000000LL,
+    0x00000ffffLL, 0LL, 0LL, 0x00000000LL,
+    0xd838091dd2253531ULL, 10LL, 0LL, 0LL};
+
+void inverse256_BTC_p_mont(unsigned char *out,const unsigned char *in)
+{
+  inverse256_skylake_core(out,in,t_BTC_p_mont);
 }
 
 /* This is the Bitcoin curve order prime */
@@ -119,7 +290,7 @@ int64_t t_BTC_n[64]={
     0x03fffffffLL, 0LL, 0LL, 0LL,
     0x03fffffffLL, 0LL, 0LL, 0LL,
     0x00000ffffLL, 0LL, 0LL, 0LL,
-    0x4b0dff665588b13fULL, 0LL, 0LL, 0LL};
+    0x4b0dff665588b13fULL, 10LL, 0LL, 0LL};
 
 unsigned char inverse256_BTC_n_modulus[32] = {
   0x41,0x41,0x36,0xd0,0x8c,0x5e,0xd2,0xbf,
@@ -130,7 +301,81 @@ unsigned char inverse256_BTC_n_modulus[32] = {
 
 void inverse256_BTC_n(unsigned char *out,const unsigned char *in)
 {
-  inverse256_skylake_asm(in,out,t_BTC_n);
+  inverse256_skylake_core(out,in,t_BTC_n);
+}
+
+void inverse256_BTC_n_batch(unsigned char *out,const unsigned char *in,long long n)
+{
+  inverse256_batch(out,in,n,t_BTC_n);
+}
+
+void inverse256_BTC_n_x4(unsigned char (*out)[32],const unsigned char (*in)[32])
+{
+  inverse256_x4(out,in,t_BTC_n);
+}
+
+void inverse256_BTC_n_vartime(unsigned char *out,const unsigned char *in)
+{
+  inverse256_vartime(out,in,t_BTC_n);
+}
+
+void inverse256_BTC_n_limbs(uint64_t *out,const uint64_t *in)
+{
+  inverse256_limbs(out,in,t_BTC_n);
+}
+
+void inverse256_BTC_n_limbs_be(uint64_t *out,const uint64_t *in)
+{
+  inverse256_limbs_be(out,in,t_BTC_n);
+}
+
+void inverse256_BTC_n_limbs30(int64_t *out,const uint64_t *in)
+{
+  inverse256_limbs30(out,in,t_BTC_n);
+}
+
+int jacobi256_BTC_n(const unsigned char *in)
+{
+  return jacobi256(in,t_BTC_n);
+}
+
+void jacobi256_BTC_n_batch(int *out,const unsigned char *in,long long n)
+{
+  jacobi256_batch(out,in,n,t_BTC_n);
+}
+
+int jacobi256_BTC_n_vartime(const unsigned char *in)
+{
+  return jacobi256_vartime(in,t_BTC_n);
+}
+
+/* the same with 2^542 mod p as the starting e, for Montgomery-form
+   input and output */
+static const __attribute__((aligned(32)))
+int64_t t_BTC_n_mont[64] = {
+    0x3FFFFFFFLL, 0x3FFFFFFFLL, 0x3FFFFFFFLL, 0x3FFFFFFFLL,
+    0x200000000LL, 0x200000000LL, 0x200000000LL, 0x200000000LL,
+    0x8000000000000000LL, 0x8000000000000000LL,
+    0x8000000000000000LL, 0x8000000000000000LL,
+    0X7FFFFFFE00000000LL, 0X7FFFFFFE00000000LL,
+    0X7FFFFFFE00000000LL, 0X7FFFFFFE00000000LL,
+    0x20000000LL, 0x20000000LL, 0x20000000LL, 0x20000000LL,
+    0xbfd25e8cd0364141ULL, 0xbaaedce6af48a03bULL,
+    0xfffffffffffffffeULL, 0xffffffffffffffffULL,
+    0x010364141LL, 0LL, 0LL, 0x2171f68bLL,
+    0x03f497a33LL, 0LL, 0LL, 0x24f11204LL,
+    0x0348a03bbLL, 0LL, 0LL, 0x0c4e17f8LL,
+    0x02bb739abLL, 0LL, 0LL, 0x334bdc65LL,
+    0x03ffffebaLL, 0LL, 0LL, 0x069863feLL,
+    0x03fffffffLL, 0LL, 0LL, 0x0d07c73cLL,
+    0x03fffffffLL, 0LL, 0LL, 0x1fd7916fLL,
+    0x03fffffffLL, 0LL, 0LL, 0x29bc5e69LL,
+    0x00000ffffLL, 0LL, 0LL, 0x00006071LL,
+    0x4b0dff665588b13fULL, 10LL, 0LL, 0LL};
+
+void inverse256_BTC_n_mont(unsigned char *out,const unsigned char *in)
+{
+  inverse256_skylake_core(out,in,t_BTC_n_mont);
 }
 
 /* This is the P-256 curve order prime */
@@ -154,7 +399,7 @@ int64_t t_P256_n[64]={
     0x000000fffLL, 0LL, 0LL, 0LL,
     0x03fffc000LL, 0LL, 0LL, 0LL,
     0x00000ffffLL, 0LL, 0LL, 0LL,
-    0xccd1c8aaee00bc4fULL, 0LL, 0LL, 0LL};
+    0xccd1c8aaee00bc4fULL, 10LL, 0LL, 0LL};
 
 unsigned char inverse256_P256_n_modulus[32] = {
   0x51,0x25,0x63,0xfc,0xc2,0xca,0xb9,0xf3,
@@ -165,7 +410,81 @@ unsigned char inverse256_P256_n_modulus[32] = {
 
 void inverse256_P256_n(unsigned char *out,const unsigned char *in)
 {
-  inverse256_skylake_asm(in,out,t_P256_n);
+  inverse256_skylake_core(out,in,t_P256_n);
+}
+
+void inverse256_P256_n_batch(unsigned char *out,const unsigned char *in,long long n)
+{
+  inverse256_batch(out,in,n,t_P256_n);
+}
+
+void inverse256_P256_n_x4(unsigned char (*out)[32],const unsigned char (*in)[32])
+{
+  inverse256_x4(out,in,t_P256_n);
+}
+
+void inverse256_P256_n_vartime(unsigned char *out,const unsigned char *in)
+{
+  inverse256_vartime(out,in,t_P256_n);
+}
+
+void inverse256_P256_n_limbs(uint64_t *out,const uint64_t *in)
+{
+  inverse256_limbs(out,in,t_P256_n);
+}
+
+void inverse256_P256_n_limbs_be(uint64_t *out,const uint64_t *in)
+{
+  inverse256_limbs_be(out,in,t_P256_n);
+}
+
+void inverse256_P256_n_limbs30(int64_t *out,const uint64_t *in)
+{
+  inverse256_limbs30(out,in,t_P256_n);
+}
+
+int jacobi256_P256_n(const unsigned char *in)
+{
+  return jacobi256(in,t_P256_n);
+}
+
+void jacobi256_P256_n_batch(int *out,const unsigned char *in,long long n)
+{
+  jacobi256_batch(out,in,n,t_P256_n);
+}
+
+int jacobi256_P256_n_vartime(const unsigned char *in)
+{
+  return jacobi256_vartime(in,t_P256_n);
+}
+
+/* the same with 2^542 mod p as the starting e, for Montgomery-form
+   input and output */
+static const __attribute__((aligned(32)))
+int64_t t_P256_n_mont[64] = {
+    0x3FFFFFFFLL, 0x3FFFFFFFLL, 0x3FFFFFFFLL, 0x3FFFFFFFLL,
+    0x200000000LL, 0x200000000LL, 0x200000000LL, 0x200000000LL,
+    0x8000000000000000LL, 0x8000000000000000LL,
+    0x8000000000000000LL, 0x8000000000000000LL,
+    0X7FFFFFFE00000000LL, 0X7FFFFFFE00000000LL,
+    0X7FFFFFFE00000000LL, 0X7FFFFFFE00000000LL,
+    0x20000000LL, 0x20000000LL, 0x20000000LL, 0x20000000LL,
+    0xf3b9cac2fc632551ULL, 0xbce6faada7179e84ULL,
+    0xffffffffffffffffULL, 0xffffffff00000000ULL,
+    0x03c632551LL, 0LL, 0LL, 0x25bb8c0bLL,
+    0x00ee72b0bLL, 0LL, 0LL, 0x087d1b88LL,
+    0x03179e84fLL, 0LL, 0LL, 0x1aa42f31LL,
+    0x039beab69LL, 0LL, 0LL, 0x2f0b7f77LL,
+    0x03fffffbcLL, 0LL, 0LL, 0x241daabdLL,
+    0x03fffffffLL, 0LL, 0LL, 0x2bec5961LL,
+    0x000000fffLL, 0LL, 0LL, 0x121294adLL,
+    0x03fffc000LL, 0LL, 0LL, 0x283b3c16LL,
+    0x00000ffffLL, 0LL, 0LL, 0x000056aeLL,
+    0xccd1c8aaee00bc4fULL, 10LL, 0LL, 0LL};
+
+void inverse256_P256_n_mont(unsigned char *out,const unsigned char *in)
+{
+  inverse256_skylake_core(out,in,t_P256_n_mont);
 }
 
 /* This is the P-256 curve Solinas prime */
@@ -189,7 +508,7 @@ int64_t t_P256_p[64]={
     0x000001000LL, 0LL, 0LL, 0LL,
     0x03fffc000LL, 0LL, 0LL, 0LL,
     0x00000ffffLL, 0LL, 0LL, 0LL,
-    0x0000000000000001ULL, 0LL, 0LL, 0LL};
+    0x0000000000000001ULL, 10LL, 0LL, 0LL};
 
 unsigned char inverse256_P256_p_modulus[32] = {
   0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
@@ -200,6 +519,97 @@ unsigned char inverse256_P256_p_modulus[32] = {
 
 void inverse256_P256_p(unsigned char *out,const unsigned char *in)
 {
-  inverse256_skylake_asm(in,out,t_P256_p);
+  inverse256_skylake_core(out,in,t_P256_p);
+}
+
+void inverse256_P256_p_batch(unsigned char *out,const unsigned char *in,long long n)
+{
+  inverse256_batch(out,in,n,t_P256_p);
+}
+
+void inverse256_P256_p_x4(unsigned char (*out)[32],const unsigned char (*in)[32])
+{
+  inverse256_x4(out,in,t_P256_p);
+}
+
+void inverse256_P256_p_vartime(unsigned char *out,const unsigned char *in)
+{
+  inverse256_vartime(out,in,t_P256_p);
+}
+
+void inverse256_P256_p_limbs(uint64_t *out,const uint64_t *in)
+{
+  inverse256_limbs(out,in,t_P256_p);
+}
+
+void inverse256_P256_p_limbs_be(uint64_t *out,const uint64_t *in)
+{
+  inverse256_limbs_be(out,in,t_P256_p);
+}
+
+void inverse256_P256_p_limbs30(int64_t *out,const uint64_t *in)
+{
+  inverse256_limbs30(out,in,t_P256_p);
+}
+
+void normalize_jacobian_P256_p(unsigned char *points,long long n)
+{
+  normalize_jacobian(points,n,t_P256_p);
+}
+
+int jacobi256_P256_p(const unsigned char *in)
+{
+  return jacobi256(in,t_P256_p);
+}
+
+void jacobi256_P256_p_batch(int *out,const unsigned char *in,long long n)
+{
+  jacobi256_batch(out,in,n,t_P256_p);
 }
 
+int jacobi256_P256_p_vartime(const unsigned char *in)
+{
+  return jacobi256_vartime(in,t_P256_p);
+}
+
+/* the same with 2^542 mod p as the starting e, for Montgomery-form
+   input and output */
+static const __attribute__((aligned(32)))
+int64_t t_P256_p_mont[64] = {
+    0x3FFFFFFFLL, 0x3FFFFFFFLL, 0x3FFFFFFFLL, 0x3FFFFFFFLL,
+    0x200000000LL, 0x200000000LL, 0x200000000LL, 0x200000000LL,
+    0x8000000000000000LL, 0x8000000000000000LL,
+    0x8000000000000000LL, 0x8000000000000000LL,
+    0X7FFFFFFE00000000LL, 0X7FFFFFFE00000000LL,
+    0X7FFFFFFE00000000LL, 0X7FFFFFFE00000000LL,
+    0x20000000LL, 0x20000000LL, 0x20000000LL, 0x20000000LL,
+    0xffffffffffffffffULL, 0x00000000ffffffffULL,
+    0x0000000000000000ULL, 0xffffffff00000001ULL,
+    0x03fffffffLL, 0LL, 0LL, 0x00000001LL,
+    0x03fffffffLL, 0LL, 0LL, 0x00000003LL,
+    0x03fffffffLL, 0LL, 0LL, 0x00000000LL,
+    0x00000003fLL, 0LL, 0LL, 0x3fffffb0LL,
+    0x000000000LL, 0LL, 0LL, 0x3ffffeffLL,
+    0x000000000LL, 0LL, 0LL, 0x3ffffeffLL,
+    0x000001000LL, 0LL, 0LL, 0x3fffefffLL,
+    0x03fffc000LL, 0LL, 0LL, 0x00001fffLL,
+    0x00000ffffLL, 0LL, 0LL, 0x00004000LL,
+    0x0000000000000001ULL, 10LL, 0LL, 0LL};
+
+void inverse256_P256_p_mont(unsigned char *out,const unsigned char *in)
+{
+  inverse256_skylake_core(out,in,t_P256_p_mont);
+}
+
+/* The tables above, which inverse256_table_cached() hands out for
+   these moduli instead of building its own. */
+
+const int64_t *inverse256_table_builtin(const unsigned char *modulus)
+{
+  if (memcmp(modulus,inverse256_sm2_p_modulus,32) == 0) return sm2_prime;
+  if (memcmp(modulus,inverse256_BTC_p_modulus,32) == 0) return t_BTC_p;
+  if (memcmp(modulus,inverse256_BTC_n_modulus,32) == 0) return t_BTC_n;
+  if (memcmp(modulus,inverse256_P256_p_modulus,32) == 0) return t_P256_p;
+  if (memcmp(modulus,inverse256_P256_n_modulus,32) == 0) return t_P256_n;
+  return 0;
+}
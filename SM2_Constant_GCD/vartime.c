@@ -0,0 +1,204 @@
+#include <stdint.h>
+#include "inverse256.h"
+#include "mont256.h"
+
+typedef __int128 int128;
+
+/* Variable-time divstep inversion, for inputs that are not secret
+   (signature verification, point decompression).  It must never see
+   a secret: the time depends on the input.
+
+   The limb layout and the [f,g], [d,e] updates are those of
+   portable.c, 5 signed limbs radix 2^62, but each round here runs 62
+   of the original divsteps (eta = -delta, starting at -1) several at
+   a time, as in the _var code of libsecp256k1: a run of zeros at the
+   bottom of g is skipped in one shift, and an odd g has up to 6 bits
+   cleared at once by adding g f(f^2-2) f, since f(f^2-2) is -1/f
+   mod 2^6.  The swap for eta < 0 is done with masks
+   rather than a branch, which on random inputs would be mispredicted
+   half the time.  The transition matrix is again scaled to 2^62, so
+   [d,e] stays exact whatever the number of rounds, and the loop stops
+   as soon as g is 0 instead of after the worst case.  As f and g
+   shrink, their top limbs become pure sign and the [f,g] update runs
+   on fewer limbs.
+
+   Takes the same table as portable.c.  This is the engine for CPUs
+   without AVX2, where it is faster than portable.c; with AVX2 the
+   constant-time asm wins even at its worst-case count of divsteps, so
+   inverse256_vartime() in cpu.c runs that instead. */
+
+#define M62 ((int64_t) (UINT64_MAX>>2))
+
+typedef struct {
+  int64_t u,v,q,r;
+} matrix;
+
+static int64_t divsteps_62_var(int64_t eta,uint64_t f,uint64_t g,matrix *t)
+{
+  uint64_t u = 1,v = 0,q = 0,r = 1;
+  uint64_t c,x,m,w;
+  int i = 62,limit,zeros;
+
+  for (;;) {
+    zeros = __builtin_ctzll(g|(UINT64_MAX<<i));
+    g >>= zeros;
+    u <<= zeros;
+    v <<= zeros;
+    eta -= zeros;
+    i -= zeros;
+    if (i == 0) break;
+    /* g is odd: if eta < 0, (f,g) = (g,-f) and eta = -eta; then add
+       the multiple of f that clears the next min(eta+1,i,6) bits of g */
+    c = eta>>63;
+    eta = (eta^c)-c;
+    x = (f^g)&c; f ^= x; g ^= x; g = (g^c)-c;
+    x = (u^q)&c; u ^= x; q ^= x; q = (q^c)-c;
+    x = (v^r)&c; v ^= x; r ^= x; r = (r^c)-c;
+    limit = (int) eta+1 > i ? i : (int) eta+1;
+    m = (UINT64_MAX>>(64-limit))&63;
+    w = (f*g*(f*f-2))&m;
+    g += f*w;
+    q += u*w;
+    r += v*w;
+  }
+  t->u = u;
+  t->v = v;
+  t->q = q;
+  t->r = r;
+  return eta;
+}
+
+/* [d,e] = t [d,e] / 2^62 mod p, keeping both in (-2p,p) */
+
+static void update_de(int64_t *d,int64_t *e,const matrix *t,const int64_t *p,int64_t pinv)
+{
+  int64_t sd = d[4]>>63,se = e[4]>>63;
+  int64_t md = (t->u&sd)+(t->v&se);
+  int64_t me = (t->q&sd)+(t->r&se);
+  int128 cd,ce;
+  int i;
+
+  cd = (int128) t->u*d[0]+(int128) t->v*e[0];
+  ce = (int128) t->q*d[0]+(int128) t->r*e[0];
+  md -= (pinv*(uint64_t) cd+md)&M62;
+  me -= (pinv*(uint64_t) ce+me)&M62;
+  cd += (int128) p[0]*md;
+  ce += (int128) p[0]*me;
+  cd >>= 62;
+  ce >>= 62;
+  for (i = 1;i < 5;++i) {
+    cd += (int128) t->u*d[i]+(int128) t->v*e[i]+(int128) p[i]*md;
+    ce += (int128) t->q*d[i]+(int128) t->r*e[i]+(int128) p[i]*me;
+    d[i-1] = (int64_t) cd&M62;
+    e[i-1] = (int64_t) ce&M62;
+    cd >>= 62;
+    ce >>= 62;
+  }
+  d[4] = cd;
+  e[4] = ce;
+}
+
+/* [f,g] = t [f,g] / 2^62, exact, on the bottom len limbs */
+
+static void update_fg(int64_t *f,int64_t *g,int len,const matrix *t)
+{
+  int128 cf,cg;
+  int i;
+
+  cf = (int128) t->u*f[0]+(int128) t->v*g[0];
+  cg = (int128) t->q*f[0]+(int128) t->r*g[0];
+  cf >>= 62;
+  cg >>= 62;
+  for (i = 1;i < len;++i) {
+    cf += (int128) t->u*f[i]+(int128) t->v*g[i];
+    cg += (int128) t->q*f[i]+(int128) t->r*g[i];
+    f[i-1] = (int64_t) cf&M62;
+    g[i-1] = (int64_t) cg&M62;
+    cf >>= 62;
+    cg >>= 62;
+  }
+  f[len-1] = cf;
+  g[len-1] = cg;
+}
+
+static void carry(int64_t *r)
+{
+  int i;
+
+  for (i = 0;i < 4;++i) {
+    r[i+1] += r[i]>>62;
+    r[i] &= M62;
+  }
+}
+
+static void to62(int64_t *r,const uint64_t *a)
+{
+  r[0] = a[0]&M62;
+  r[1] = ((a[0]>>62)|(a[1]<<2))&M62;
+  r[2] = ((a[1]>>60)|(a[2]<<4))&M62;
+  r[3] = ((a[2]>>58)|(a[3]<<6))&M62;
+  r[4] = a[3]>>56;
+}
+
+static void from62(uint64_t *a,const int64_t *r)
+{
+  a[0] = r[0]|((uint64_t) r[1]<<62);
+  a[1] = (r[1]>>2)|((uint64_t) r[2]<<60);
+  a[2] = (r[2]>>4)|((uint64_t) r[3]<<58);
+  a[3] = (r[3]>>6)|((uint64_t) r[4]<<56);
+}
+
+void inverse256_vartime_portable(unsigned char *out,const unsigned char *in,const int64_t *table)
+{
+  int64_t p[5],f[5],g[5],d[5],e[5];
+  int64_t eta = -1,pinv,sign,cond;
+  uint64_t a[4];
+  matrix t;
+  int i,len = 5;
+
+  to62(p,(const uint64_t *) (table+20));
+  mont256_load(a,in,table);
+  to62(g,a);
+  for (i = 0;i < 5;++i) {
+    f[i] = p[i];
+    d[i] = 0;
+  }
+  mont256_start(a,table);
+  to62(e,a);
+  pinv = (-table[60])&M62;
+
+  for (;;) {
+    eta = divsteps_62_var(eta,f[0],g[0],&t);
+    update_de(d,e,&t,p,pinv);
+    update_fg(f,g,len,&t);
+
+    if (g[0] == 0) {
+      cond = 0;
+      for (i = 1;i < len;++i) cond |= g[i];
+      if (!cond) break;
+    }
+
+    /* drop the top limb once it is only sign in both f and g */
+    cond = ((int64_t) len-2)>>63;
+    cond |= f[len-1]^(f[len-1]>>63);
+    cond |= g[len-1]^(g[len-1]>>63);
+    if (!cond) {
+      f[len-2] |= (uint64_t) f[len-1]<<62;
+      g[len-2] |= (uint64_t) g[len-1]<<62;
+      --len;
+    }
+  }
+
+  /* f = +-1 (or +-gcd, when there is no inverse); d*sign(f) mod p */
+  sign = f[len-1]>>63;
+  cond = d[4]>>63;
+  for (i = 0;i < 5;++i) d[i] += p[i]&cond;
+  for (i = 0;i < 5;++i) d[i] = (d[i]^sign)-sign;
+  carry(d);
+  if (d[4] < 0) {
+    for (i = 0;i < 5;++i) d[i] += p[i];
+    carry(d);
+  }
+  from62(a,d);
+  mont256_store(out,a);
+}
@@ -0,0 +1,67 @@
+#ifndef inversewide_h
+#define inversewide_h
+
+#include <stdint.h>
+
+/* Reference implementation in portable C: constant time, but slower
+   than mpz_invert() at 384 bits and up; see README.  192 and 224 bits
+   run the 256-bit engine of ../SM2_Constant_GCD. */
+
+#define inverse192_P192_p inversewide_portable_P192_p
+#define inverse192_P192_n inversewide_portable_P192_n
+#define inverse224_P224_p inversewide_portable_P224_p
+#define inverse224_P224_n inversewide_portable_P224_n
+#define inverse384_P384_p inversewide_portable_P384_p
+#define inverse384_P384_n inversewide_portable_P384_n
+#define inverse448_C448_p inversewide_portable_C448_p
+#define inverse448_E448_n inversewide_portable_E448_n
+#define inverse521_P521_p inversewide_portable_P521_p
+#define inverse521_P521_n inversewide_portable_P521_n
+
+#define inverse192 inversewide_portable_192
+#define inverse224 inversewide_portable_224
+#define inverse384 inversewide_portable_384
+#define inverse448 inversewide_portable_448
+#define inverse521 inversewide_portable_521
+#define inversewide inversewide_portable
+
+#define inversewide_table_init inversewide_portable_table_init
+
+/* Little-endian inputs and outputs of 24, 28, 48, 56 and 66 bytes; any
+   input below 2^192, 2^224, 2^384, 2^448, 2^528 is accepted and 1/0 = 0. */
+extern void inverse192_P192_p(unsigned char *,const unsigned char *);
+extern void inverse192_P192_n(unsigned char *,const unsigned char *);
+extern void inverse224_P224_p(unsigned char *,const unsigned char *);
+extern void inverse224_P224_n(unsigned char *,const unsigned char *);
+extern void inverse384_P384_p(unsigned char *,const unsigned char *);
+extern void inverse384_P384_n(unsigned char *,const unsigned char *);
+extern void inverse448_C448_p(unsigned char *,const unsigned char *);
+extern void inverse448_E448_n(unsigned char *,const unsigned char *);
+extern void inverse521_P521_p(unsigned char *,const unsigned char *);
+extern void inverse521_P521_n(unsigned char *,const unsigned char *);
+
+/* the engines, one per width, for a table made by inversewide_table_init();
+   inversewide() picks the engine from the table */
+extern void inverse192(unsigned char *,const unsigned char *,const int64_t *);
+extern void inverse224(unsigned char *,const unsigned char *,const int64_t *);
+extern void inverse384(unsigned char *,const unsigned char *,const int64_t *);
+extern void inverse448(unsigned char *,const unsigned char *,const int64_t *);
+extern void inverse521(unsigned char *,const unsigned char *,const int64_t *);
+extern void inversewide(unsigned char *,const unsigned char *,const int64_t *);
+
+/* 96-entry table for an odd modulus 3 <= p < 2^(8*bytes), bytes 24, 28,
+   48, 56 or 66 (p below 2^521 for 66); -1 on a bad modulus or size */
+extern int inversewide_table_init(int64_t *,const unsigned char *,long long);
+
+extern unsigned char inverse192_P192_p_modulus[24];
+extern unsigned char inverse192_P192_n_modulus[24];
+extern unsigned char inverse224_P224_p_modulus[28];
+extern unsigned char inverse224_P224_n_modulus[28];
+extern unsigned char inverse384_P384_p_modulus[48];
+extern unsigned char inverse384_P384_n_modulus[48];
+extern unsigned char inverse448_C448_p_modulus[56];
+extern unsigned char inverse448_E448_n_modulus[56];
+extern unsigned char inverse521_P521_p_modulus[66];
+extern unsigned char inverse521_P521_n_modulus[66];
+
+#endif
@@ -0,0 +1,332 @@
+#include <stdint.h>
+#include "inversewide.h"
+
+/* Tables in the layout described in wide.c, as built by
+   inversewide_table_init() for the moduli below: the width in bytes,
+   the size of p in bits, the number and kind of rounds, 1/p mod 2^62
+   at position 4, p radix 2^62 at 8.. and p radix 2^64 at 20..; for
+   192 and 224 bits, only the width, size, rounds and p radix 2^64,
+   and the inverse256 table at 32...  The moduli are also given as
+   little-endian bytes for the tests. */
+
+/* p = 2^192 - 2^64 - 1 */
+
+static const __attribute__((aligned(32)))
+int64_t P192_p_table[96] = {
+  24LL, 192LL, 8LL, 1LL,
+  0LL, 0LL, 0LL, 0LL,
+  0LL, 0LL, 0LL, 0LL, 0LL, 0LL, 0LL, 0LL, 0LL,
+  0LL, 0LL, 0LL,
+  0xffffffffffffffffULL, 0xfffffffffffffffeULL, 0xffffffffffffffffULL,
+  0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL,
+  0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL,
+  0LL, 0LL, 0LL,
+  /* inverse256_table_init() */
+  0x000000003fffffffULL, 0x000000003fffffffULL, 0x000000003fffffffULL, 0x000000003fffffffULL,
+  0x0000000200000000ULL, 0x0000000200000000ULL, 0x0000000200000000ULL, 0x0000000200000000ULL,
+  0x8000000000000000ULL, 0x8000000000000000ULL, 0x8000000000000000ULL, 0x8000000000000000ULL,
+  0x7ffffffe00000000ULL, 0x7ffffffe00000000ULL, 0x7ffffffe00000000ULL, 0x7ffffffe00000000ULL,
+  0x0000000020000000ULL, 0x0000000020000000ULL, 0x0000000020000000ULL, 0x0000000020000000ULL,
+  0xffffffffffffffffULL, 0xfffffffffffffffeULL, 0xffffffffffffffffULL, 0x0000000000000000ULL,
+  0x000000003fffffffULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x000000003fffffffULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000001ULL,
+  0x000000003fffffefULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x000000003fffffffULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x000000003fffffffULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x000000003fffffffULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x0000000000000fffULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x0000000000000001ULL, 0x0000000000000008ULL, 0x0000000000000000ULL, 0x0000000000000000ULL } ;
+
+unsigned char inverse192_P192_p_modulus[24] = {
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xfe,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+} ;
+
+void inverse192_P192_p(unsigned char *out,const unsigned char *in)
+{
+  inverse192(out,in,P192_p_table);
+}
+
+/* P-192 group order */
+
+static const __attribute__((aligned(32)))
+int64_t P192_n_table[96] = {
+  24LL, 192LL, 8LL, 1LL,
+  0LL, 0LL, 0LL, 0LL,
+  0LL, 0LL, 0LL, 0LL, 0LL, 0LL, 0LL, 0LL, 0LL,
+  0LL, 0LL, 0LL,
+  0x146bc9b1b4d22831LL, 0xffffffff99def836ULL, 0xffffffffffffffffULL,
+  0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL,
+  0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL,
+  0LL, 0LL, 0LL,
+  /* inverse256_table_init() */
+  0x000000003fffffffULL, 0x000000003fffffffULL, 0x000000003fffffffULL, 0x000000003fffffffULL,
+  0x0000000200000000ULL, 0x0000000200000000ULL, 0x0000000200000000ULL, 0x0000000200000000ULL,
+  0x8000000000000000ULL, 0x8000000000000000ULL, 0x8000000000000000ULL, 0x8000000000000000ULL,
+  0x7ffffffe00000000ULL, 0x7ffffffe00000000ULL, 0x7ffffffe00000000ULL, 0x7ffffffe00000000ULL,
+  0x0000000020000000ULL, 0x0000000020000000ULL, 0x0000000020000000ULL, 0x0000000020000000ULL,
+  0x146bc9b1b4d22831ULL, 0xffffffff99def836ULL, 0xffffffffffffffffULL, 0x0000000000000000ULL,
+  0x0000000034d22831ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x0000000011af26c6ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000001ULL,
+  0x000000001def8361ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x000000003fffffe6ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x000000003fffffffULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x000000003fffffffULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x0000000000000fffULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x882672070ddbcf2fULL, 0x0000000000000008ULL, 0x0000000000000000ULL, 0x0000000000000000ULL } ;
+
+unsigned char inverse192_P192_n_modulus[24] = {
+  0x31,0x28,0xd2,0xb4,0xb1,0xc9,0x6b,0x14,0x36,0xf8,0xde,0x99,0xff,0xff,0xff,0xff,
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+} ;
+
+void inverse192_P192_n(unsigned char *out,const unsigned char *in)
+{
+  inverse192(out,in,P192_n_table);
+}
+
+/* p = 2^224 - 2^96 + 1 */
+
+static const __attribute__((aligned(32)))
+int64_t P224_p_table[96] = {
+  28LL, 224LL, 9LL, 1LL,
+  0LL, 0LL, 0LL, 0LL,
+  0LL, 0LL, 0LL, 0LL, 0LL, 0LL, 0LL, 0LL, 0LL,
+  0LL, 0LL, 0LL,
+  0x0000000000000001LL, 0xffffffff00000000ULL, 0xffffffffffffffffULL,
+  0x00000000ffffffffLL, 0x0000000000000000LL, 0x0000000000000000LL,
+  0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL,
+  0LL, 0LL, 0LL,
+  /* inverse256_table_init() */
+  0x000000003fffffffULL, 0x000000003fffffffULL, 0x000000003fffffffULL, 0x000000003fffffffULL,
+  0x0000000200000000ULL, 0x0000000200000000ULL, 0x0000000200000000ULL, 0x0000000200000000ULL,
+  0x8000000000000000ULL, 0x8000000000000000ULL, 0x8000000000000000ULL, 0x8000000000000000ULL,
+  0x7ffffffe00000000ULL, 0x7ffffffe00000000ULL, 0x7ffffffe00000000ULL, 0x7ffffffe00000000ULL,
+  0x0000000020000000ULL, 0x0000000020000000ULL, 0x0000000020000000ULL, 0x0000000020000000ULL,
+  0x0000000000000001ULL, 0xffffffff00000000ULL, 0xffffffffffffffffULL, 0x00000000ffffffffULL,
+  0x0000000000000001ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000001ULL,
+  0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x000000003fffffc0ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x000000003fffffffULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x000000003fffffffULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x000000003fffffffULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x0000000000003fffULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0xffffffffffffffffULL, 0x0000000000000009ULL, 0x0000000000000000ULL, 0x0000000000000000ULL } ;
+
+unsigned char inverse224_P224_p_modulus[28] = {
+  0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xff,0xff,0xff,0xff,
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+} ;
+
+void inverse224_P224_p(unsigned char *out,const unsigned char *in)
+{
+  inverse224(out,in,P224_p_table);
+}
+
+/* P-224 group order */
+
+static const __attribute__((aligned(32)))
+int64_t P224_n_table[96] = {
+  28LL, 224LL, 9LL, 1LL,
+  0LL, 0LL, 0LL, 0LL,
+  0LL, 0LL, 0LL, 0LL, 0LL, 0LL, 0LL, 0LL, 0LL,
+  0LL, 0LL, 0LL,
+  0x13dd29455c5c2a3dLL, 0xffff16a2e0b8f03eULL, 0xffffffffffffffffULL,
+  0x00000000ffffffffLL, 0x0000000000000000LL, 0x0000000000000000LL,
+  0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL,
+  0LL, 0LL, 0LL,
+  /* inverse256_table_init() */
+  0x000000003fffffffULL, 0x000000003fffffffULL, 0x000000003fffffffULL, 0x000000003fffffffULL,
+  0x0000000200000000ULL, 0x0000000200000000ULL, 0x0000000200000000ULL, 0x0000000200000000ULL,
+  0x8000000000000000ULL, 0x8000000000000000ULL, 0x8000000000000000ULL, 0x8000000000000000ULL,
+  0x7ffffffe00000000ULL, 0x7ffffffe00000000ULL, 0x7ffffffe00000000ULL, 0x7ffffffe00000000ULL,
+  0x0000000020000000ULL, 0x0000000020000000ULL, 0x0000000020000000ULL, 0x0000000020000000ULL,
+  0x13dd29455c5c2a3dULL, 0xffff16a2e0b8f03eULL, 0xffffffffffffffffULL, 0x00000000ffffffffULL,
+  0x000000001c5c2a3dULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x000000000f74a515ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000001ULL,
+  0x000000000b8f03e1ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x000000003fc5a8b8ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x000000003fffffffULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x000000003fffffffULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x000000003fffffffULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x0000000000003fffULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+  0xd6e242706a1fc2ebULL, 0x0000000000000009ULL, 0x0000000000000000ULL, 0x0000000000000000ULL } ;
+
+unsigned char inverse224_P224_n_modulus[28] = {
+  0x3d,0x2a,0x5c,0x5c,0x45,0x29,0xdd,0x13,0x3e,0xf0,0xb8,0xe0,0xa2,0x16,0xff,0xff,
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+} ;
+
+void inverse224_P224_n(unsigned char *out,const unsigned char *in)
+{
+  inverse224(out,in,P224_n_table);
+}
+
+/* p = 2^384 - 2^128 - 2^96 + 2^32 - 1 */
+
+static const __attribute__((aligned(32)))
+int64_t P384_p_table[96] = {
+  48LL, 384LL, 18LL, 0LL,
+  0x3ffffffeffffffffLL, 0LL, 0LL, 0LL,
+  0x00000000ffffffffLL, 0x3ffffffc00000000LL, 0x3fffffffffffffefLL,
+  0x3fffffffffffffffLL, 0x3fffffffffffffffLL, 0x3fffffffffffffffLL,
+  0x0000000000000fffLL, 0x0000000000000000LL, 0x0000000000000000LL,
+  0LL, 0LL, 0LL,
+  0x00000000ffffffffLL, 0xffffffff00000000ULL, 0xfffffffffffffffeULL,
+  0xffffffffffffffffULL, 0xffffffffffffffffULL, 0xffffffffffffffffULL,
+  0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL,
+  0LL, 0LL, 0LL } ;
+
+unsigned char inverse384_P384_p_modulus[48] = {
+  0xff,0xff,0xff,0xff,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xff,0xff,0xff,0xff,
+  0xfe,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+} ;
+
+void inverse384_P384_p(unsigned char *out,const unsigned char *in)
+{
+  inverse384(out,in,P384_p_table);
+}
+
+/* P-384 group order */
+
+static const __attribute__((aligned(32)))
+int64_t P384_n_table[96] = {
+  48LL, 384LL, 18LL, 0LL,
+  0x112b9f76177023bbLL, 0LL, 0LL, 0LL,
+  0x2cec196accc52973LL, 0x206836c922c29debLL, 0x3634d81f4372ddf5LL,
+  0x3ffffffffffffff1LL, 0x3fffffffffffffffLL, 0x3fffffffffffffffLL,
+  0x0000000000000fffLL, 0x0000000000000000LL, 0x0000000000000000LL,
+  0LL, 0LL, 0LL,
+  0xecec196accc52973ULL, 0x581a0db248b0a77aLL, 0xc7634d81f4372ddfULL,
+  0xffffffffffffffffULL, 0xffffffffffffffffULL, 0xffffffffffffffffULL,
+  0x0000000000000000LL, 0x0000000000000000LL, 0x0000000000000000LL,
+  0LL, 0LL, 0LL } ;
+
+unsigned char inverse384_P384_n_modulus[48] = {
+  0x73,0x29,0xc5,0xcc,0x6a,0x19,0xec,0xec,0x7a,0xa7,0xb0,0x48,0xb2,0x0d,0x1a,0x58,
+  0xdf,0x2d,0x37,0xf4,0x81,0x4d,0x63,0xc7,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+} ;
+
+void inverse384_P384_n(unsigned char *out,const unsigned char *in)
+{
+  inverse384(out,in,P384_n_table);
+}
+
+/* p = 2^448 - 2^224 - 1 */
+
+static const __attribute__((aligned(32)))
+int64_t C448_p_table[96] = {
+  56LL, 448LL, 21LL, 0LL,
+  0x3fffffffffffffffLL, 0LL, 0LL, 0LL,
+  0x3fffffffffffffffLL, 0x3fffffffffffffffLL, 0x3fffffffffffffffLL,
+  0x3fffffbfffffffffLL, 0x3fffffffffffffffLL, 0x3fffffffffffffffLL,
+  0x3fffffffffffffffLL, 0x0000000000003fffLL, 0x0000000000000000LL,
+  0LL, 0LL, 0LL,
+  0xffffffffffffffffULL, 0xffffffffffffffffULL, 0xffffffffffffffffULL,
+  0xfffffffeffffffffULL, 0xffffffffffffffffULL, 0xffffffffffffffffULL,
+  0xffffffffffffffffULL, 0x0000000000000000LL, 0x0000000000000000LL,
+  0LL, 0LL, 0LL } ;
+
+unsigned char inverse448_C448_p_modulus[56] = {
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xfe,0xff,0xff,0xff,
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+} ;
+
+void inverse448_C448_p(unsigned char *out,const unsigned char *in)
+{
+  inverse448(out,in,C448_p_table);
+}
+
+/* Ed448 group order, 2^446 - 13818066809895115352007386748515426880336692474882178609894547503885 */
+
+static const __attribute__((aligned(32)))
+int64_t E448_n_table[96] = {
+  56LL, 446LL, 21LL, 0LL,
+  0x3c42bbf0516e743bLL, 0LL, 0LL, 0LL,
+  0x2378c292ab5844f3LL, 0x05b309ca37163d54LL, 0x04edb49aed636902LL,
+  0x3fffffdf3288fa71LL, 0x3fffffffffffffffLL, 0x3fffffffffffffffLL,
+  0x3fffffffffffffffLL, 0x0000000000000fffLL, 0x0000000000000000LL,
+  0LL, 0LL, 0LL,
+  0x2378c292ab5844f3LL, 0x216cc2728dc58f55LL, 0xc44edb49aed63690ULL,
+  0xffffffff7cca23e9ULL, 0xffffffffffffffffULL, 0xffffffffffffffffULL,
+  0x3fffffffffffffffLL, 0x0000000000000000LL, 0x0000000000000000LL,
+  0LL, 0LL, 0LL } ;
+
+unsigned char inverse448_E448_n_modulus[56] = {
+  0xf3,0x44,0x58,0xab,0x92,0xc2,0x78,0x23,0x55,0x8f,0xc5,0x8d,0x72,0xc2,0x6c,0x21,
+  0x90,0x36,0xd6,0xae,0x49,0xdb,0x4e,0xc4,0xe9,0x23,0xca,0x7c,0xff,0xff,0xff,0xff,
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0x3f,
+} ;
+
+void inverse448_E448_n(unsigned char *out,const unsigned char *in)
+{
+  inverse448(out,in,E448_n_table);
+}
+
+/* p = 2^521 - 1 */
+
+static const __attribute__((aligned(32)))
+int64_t P521_p_table[96] = {
+  66LL, 521LL, 25LL, 0LL,
+  0x3fffffffffffffffLL, 0LL, 0LL, 0LL,
+  0x3fffffffffffffffLL, 0x3fffffffffffffffLL, 0x3fffffffffffffffLL,
+  0x3fffffffffffffffLL, 0x3fffffffffffffffLL, 0x3fffffffffffffffLL,
+  0x3fffffffffffffffLL, 0x3fffffffffffffffLL, 0x0000000001ffffffLL,
+  0LL, 0LL, 0LL,
+  0xffffffffffffffffULL, 0xffffffffffffffffULL, 0xffffffffffffffffULL,
+  0xffffffffffffffffULL, 0xffffffffffffffffULL, 0xffffffffffffffffULL,
+  0xffffffffffffffffULL, 0xffffffffffffffffULL, 0x00000000000001ffLL,
+  0LL, 0LL, 0LL } ;
+
+unsigned char inverse521_P521_p_modulus[66] = {
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+  0xff,0x01,
+} ;
+
+void inverse521_P521_p(unsigned char *out,const unsigned char *in)
+{
+  inverse521(out,in,P521_p_table);
+}
+
+/* P-521 group order */
+
+static const __attribute__((aligned(32)))
+int64_t P521_n_table[96] = {
+  66LL, 521LL, 25LL, 0LL,
+  0x22d0a33286566a39LL, 0LL, 0LL, 0LL,
+  0x3b6fb71e91386409LL, 0x2ed726e226711ebaLL, 0x3cc0148f709a5d03LL,
+  0x21a1e0efcbe59adfLL, 0x3ffffffffffffa51LL, 0x3fffffffffffffffLL,
+  0x3fffffffffffffffLL, 0x3fffffffffffffffLL, 0x0000000001ffffffLL,
+  0LL, 0LL, 0LL,
+  0xbb6fb71e91386409ULL, 0x3bb5c9b8899c47aeLL, 0x7fcc0148f709a5d0LL,
+  0x51868783bf2f966bLL, 0xfffffffffffffffaULL, 0xffffffffffffffffULL,
+  0xffffffffffffffffULL, 0xffffffffffffffffULL, 0x00000000000001ffLL,
+  0LL, 0LL, 0LL } ;
+
+unsigned char inverse521_P521_n_modulus[66] = {
+  0x09,0x64,0x38,0x91,0x1e,0xb7,0x6f,0xbb,0xae,0x47,0x9c,0x89,0xb8,0xc9,0xb5,0x3b,
+  0xd0,0xa5,0x09,0xf7,0x48,0x01,0xcc,0x7f,0x6b,0x96,0x2f,0xbf,0x83,0x87,0x86,0x51,
+  0xfa,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+  0xff,0x01,
+} ;
+
+void inverse521_P521_n(unsigned char *out,const unsigned char *in)
+{
+  inverse521(out,in,P521_n_table);
+}
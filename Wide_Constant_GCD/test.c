@@ -0,0 +1,343 @@
+#include <gmp.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "inversewide.h"
+#include "measure.h"
+
+/* The checks of ../SM2_Constant_GCD/test.c at 192 to 521 bits,
+   through gmp, and cycle counts against mpz_invert() and Fermat
+   (mpz_powm_sec(), gmp's constant-time exponentiation, to p-2). */
+
+void gmp_import(mpz_t z,const unsigned char *s,unsigned long long slen)
+{
+  mpz_import(z,slen,-1,1,0,0,s);
+}
+
+int gmp_export(unsigned char *s,unsigned long long slen,mpz_t z)
+{
+  unsigned long long i;
+  if (mpz_sizeinbase(z,256) > slen) return -1;
+  for (i = 0;i < slen;++i) s[i] = 0;
+  mpz_export(s,0,-1,1,0,0,z);
+  return 0;
+}
+
+#define NUMPRIMES 10
+struct {
+  const char *name;
+  void (*inverse)(unsigned char *,const unsigned char *);
+  void (*engine)(unsigned char *,const unsigned char *,const int64_t *);
+  unsigned char *modulus;
+  long long bytes;
+  mpz_t gmp;
+  mpz_t top;   /* 2^(8*bytes) */
+} primes[NUMPRIMES] = {
+  { "P192_p", inverse192_P192_p, inverse192, inverse192_P192_p_modulus, 24 },
+  { "P192_n", inverse192_P192_n, inverse192, inverse192_P192_n_modulus, 24 },
+  { "P224_p", inverse224_P224_p, inverse224, inverse224_P224_p_modulus, 28 },
+  { "P224_n", inverse224_P224_n, inverse224, inverse224_P224_n_modulus, 28 },
+  { "P384_p", inverse384_P384_p, inverse384, inverse384_P384_p_modulus, 48 },
+  { "P384_n", inverse384_P384_n, inverse384, inverse384_P384_n_modulus, 48 },
+  { "C448_p", inverse448_C448_p, inverse448, inverse448_C448_p_modulus, 56 },
+  { "E448_n", inverse448_E448_n, inverse448, inverse448_E448_n_modulus, 56 },
+  { "P521_p", inverse521_P521_p, inverse521, inverse521_P521_p_modulus, 66 },
+  { "P521_n", inverse521_P521_n, inverse521, inverse521_P521_n_modulus, 66 },
+} ;
+
+mpz_t x_gmp;
+mpz_t y_gmp;
+mpz_t xy_gmp;
+mpz_t z_gmp;
+mpz_t twop_gmp;
+
+/* y = 1/x: y < p, x*y = 1 (mod p) unless x = 0 (mod p), when y = 0;
+   1/y = x mod p; x - kp down to x mod p and x + kp up to 2^(8*bytes)
+   all give y */
+
+void doit(const unsigned char *x,long long k)
+{
+  long long bytes = primes[k].bytes;
+  mpz_t *p_gmp = &primes[k].gmp;
+  unsigned char y[66];
+  unsigned char z[66];
+
+  gmp_import(x_gmp,x,bytes);
+
+  primes[k].inverse(y,x);
+  gmp_import(y_gmp,y,bytes);
+
+  assert(mpz_cmp_ui(y_gmp,0) >= 0);
+  assert(mpz_cmp(y_gmp,*p_gmp) < 0);
+
+  mpz_mul(xy_gmp,x_gmp,y_gmp);
+  mpz_mod(xy_gmp,xy_gmp,*p_gmp);
+
+  if (mpz_cmp_ui(xy_gmp,1) != 0) {
+    assert(mpz_cmp_ui(xy_gmp,0) == 0);
+    mpz_mod(xy_gmp,x_gmp,*p_gmp);
+    assert(mpz_cmp_ui(xy_gmp,0) == 0);
+    assert(mpz_cmp_ui(y_gmp,0) == 0);
+  }
+
+  primes[k].inverse(z,y);
+  gmp_import(z_gmp,z,bytes);
+  mpz_mod(xy_gmp,x_gmp,*p_gmp);
+  assert(mpz_cmp(z_gmp,xy_gmp) == 0);
+
+  mpz_set(z_gmp,x_gmp);
+  while (mpz_cmp(z_gmp,*p_gmp) >= 0) {
+    mpz_sub(z_gmp,z_gmp,*p_gmp);
+    assert(gmp_export(z,bytes,z_gmp) == 0);
+    primes[k].inverse(z,z);
+    assert(memcmp(y,z,bytes) == 0);
+  }
+
+  mpz_set(z_gmp,x_gmp);
+  for (;;) {
+    mpz_add(z_gmp,z_gmp,*p_gmp);
+    if (mpz_cmp(z_gmp,primes[k].top) >= 0) break;
+    assert(gmp_export(z,bytes,z_gmp) == 0);
+    primes[k].inverse(z,z);
+    assert(memcmp(y,z,bytes) == 0);
+  }
+}
+
+/* cycles per inversion for each width, as in bench() there */
+
+static unsigned char bx[66];
+static long long bk;
+static mpz_t bx_gmp,by_gmp,bexp_gmp;
+
+static void safegcd(void *arg)
+{
+  primes[bk].inverse(bx,bx);
+}
+
+static void gmp(void *arg)
+{
+  mpz_invert(by_gmp,bx_gmp,primes[bk].gmp);
+}
+
+static void fermat(void *arg)
+{
+  mpz_powm_sec(by_gmp,bx_gmp,bexp_gmp,primes[bk].gmp);
+}
+
+void bench(void)
+{
+  measure_result r;
+  char name[64];
+  long long i;
+
+  measure_init(0);
+  printf("nothing cycles %lld\n",measure_overhead());
+  mpz_inits(bx_gmp,by_gmp,bexp_gmp,NULL);
+  for (bk = 0;bk < NUMPRIMES;++bk) {
+    for (i = 0;i < primes[bk].bytes;++i) bx[i] = 3*i+1;
+    gmp_import(bx_gmp,bx,primes[bk].bytes);
+    mpz_mod(bx_gmp,bx_gmp,primes[bk].gmp);
+    mpz_sub_ui(bexp_gmp,primes[bk].gmp,2);
+
+    snprintf(name,sizeof name,"safegcd-ref %s",primes[bk].name);
+    measure(&r,safegcd,0,1);
+    measure_print(name,&r);
+    snprintf(name,sizeof name,"mpz_invert %s",primes[bk].name);
+    measure(&r,gmp,0,1);
+    measure_print(name,&r);
+    snprintf(name,sizeof name,"mpz_powm_sec %s",primes[bk].name);
+    measure(&r,fermat,0,1);
+    measure_print(name,&r);
+  }
+  mpz_clears(bx_gmp,by_gmp,bexp_gmp,NULL);
+}
+
+/* 2000 integers near the modulus */
+
+void nearmodulus(long long k)
+{
+  unsigned char x[66];
+  long long i;
+
+  for (i = -1000;i < 1000;++i) {
+    mpz_set_si(x_gmp,i);
+    mpz_add(x_gmp,x_gmp,primes[k].gmp);
+    mpz_mod(x_gmp,x_gmp,primes[k].gmp);
+    assert(gmp_export(x,primes[k].bytes,x_gmp) == 0);
+    doit(x,k);
+  }
+}
+
+/* 1000 integers below 2^(8*bytes) */
+
+void neartop(long long k)
+{
+  unsigned char x[66];
+  long long i;
+
+  for (i = -1000;i < 0;++i) {
+    mpz_set_si(x_gmp,i);
+    mpz_add(x_gmp,x_gmp,primes[k].top);
+    assert(gmp_export(x,primes[k].bytes,x_gmp) == 0);
+    doit(x,k);
+  }
+}
+
+/* 200 integers times each power of 2 below 2^(8*bytes) */
+
+void powers(long long k)
+{
+  unsigned char x[66];
+  long long i,c;
+
+  for (c = 0;c < 8*primes[k].bytes;++c) {
+    mpz_ui_pow_ui(twop_gmp,2,c);
+    for (i = -100;i < 100;++i) {
+      mpz_set_si(x_gmp,i);
+      mpz_mul(x_gmp,x_gmp,twop_gmp);
+      mpz_mod(x_gmp,x_gmp,primes[k].gmp);
+      assert(gmp_export(x,primes[k].bytes,x_gmp) == 0);
+      doit(x,k);
+    }
+  }
+}
+
+/* the tables in table.c are the ones inversewide_table_init() builds:
+   the same results through inversewide() on a fresh table */
+
+void checkgeneric(long long k)
+{
+  int64_t table[96];
+  unsigned char x[66];
+  unsigned char y[66];
+  unsigned char z[66];
+  long long i,j;
+
+  assert(inversewide_table_init(table,primes[k].modulus,primes[k].bytes) == 0);
+  for (i = 0;i < 1000;++i) {
+    for (j = 0;j < primes[k].bytes;++j) x[j] = random();
+    primes[k].inverse(y,x);
+    inversewide(z,x,table);
+    assert(memcmp(y,z,primes[k].bytes) == 0);
+    primes[k].engine(z,x,table);
+    assert(memcmp(y,z,primes[k].bytes) == 0);
+  }
+}
+
+/* random odd moduli of every size up to each width, prime or not,
+   against mpz_invert(); without an inverse only the range is checked.
+   The round count shrinks with the size of the modulus, so this also
+   runs the short counts. */
+
+static const long long widths[] = { 24, 28, 48, 56, 66 } ;
+
+void checkrandom(long long bytes)
+{
+  gmp_randstate_t rand;
+  mpz_t m,x,y,want;
+  unsigned char modulus[66];
+  unsigned char in[66];
+  unsigned char out[66];
+  int64_t table[96];
+  long long bits,maxbits = bytes == 66 ? 521 : 8*bytes;
+  long long i;
+
+  gmp_randinit_default(rand);
+  mpz_inits(m,x,y,want,NULL);
+  assert(inversewide_table_init(table,(const unsigned char *) "\002",1) == -1);
+  for (bits = 2;bits <= maxbits;++bits)
+    for (i = 0;i < 4;++i) {
+      mpz_urandomb(m,rand,bits-1);
+      mpz_setbit(m,bits-1);
+      mpz_setbit(m,0);
+      if (i == 0) mpz_nextprime(m,m);
+      if (mpz_sizeinbase(m,2) > maxbits) continue;
+      assert(gmp_export(modulus,bytes,m) == 0);
+      if (mpz_cmp_ui(m,1) == 0) {
+        assert(inversewide_table_init(table,modulus,bytes) == -1);
+        continue;
+      }
+      assert(inversewide_table_init(table,modulus,bytes) == 0);
+
+      mpz_urandomb(x,rand,8*bytes);
+      assert(gmp_export(in,bytes,x) == 0);
+      inversewide(out,in,table);
+      gmp_import(y,out,bytes);
+      assert(mpz_cmp(y,m) < 0);
+      if (mpz_invert(want,x,m)) assert(mpz_cmp(y,want) == 0);
+    }
+
+  /* 66 bytes hold moduli above 2^521, which the round count does not cover */
+  if (bytes == 66) {
+    mpz_setbit(m,521);
+    assert(gmp_export(modulus,bytes,m) == 0);
+    assert(inversewide_table_init(table,modulus,bytes) == -1);
+  }
+  modulus[0] = 0;
+  assert(inversewide_table_init(table,modulus,bytes) == -1);
+
+  mpz_clears(m,x,y,want,NULL);
+  gmp_randclear(rand);
+}
+
+int main(int argc, char *argv[])
+{
+  unsigned char x[66];
+  long long i,k,n;
+  char *tag = argc > 1 ? argv[1] : "";
+
+  for (k = 0;k < NUMPRIMES;++k) {
+    mpz_init(primes[k].gmp);
+    mpz_init(primes[k].top);
+    gmp_import(primes[k].gmp,primes[k].modulus,primes[k].bytes);
+    mpz_ui_pow_ui(primes[k].top,2,8*primes[k].bytes);
+    gmp_printf("%smodulus %s = 0x%Zx\n",tag,primes[k].name,primes[k].gmp);
+  }
+
+  bench();
+
+  mpz_inits(x_gmp,y_gmp,xy_gmp,z_gmp,twop_gmp,NULL);
+
+  for (k = 0;k < NUMPRIMES;++k) {
+    printf("%s%s checking 2000 integers near modulus\n",tag,primes[k].name);
+    fflush(stdout);
+    nearmodulus(k);
+  }
+
+  for (k = 0;k < NUMPRIMES;++k) {
+    printf("%s%s checking 1000 integers near 2^%lld\n",tag,primes[k].name,8*primes[k].bytes);
+    fflush(stdout);
+    neartop(k);
+  }
+
+  for (k = 0;k < NUMPRIMES;++k) {
+    printf("%s%s checking 200 integers times %lld powers of 2\n",tag,primes[k].name,8*primes[k].bytes);
+    fflush(stdout);
+    powers(k);
+  }
+
+  for (k = 0;k < NUMPRIMES;++k) {
+    printf("%s%s checking generated tables\n",tag,primes[k].name);
+    checkgeneric(k);
+  }
+
+  for (i = 0;i < sizeof widths/sizeof widths[0];++i) {
+    printf("%schecking random moduli of up to %lld bytes\n",tag,widths[i]);
+    fflush(stdout);
+    checkrandom(widths[i]);
+  }
+
+  printf("%schecking random integers from stdin\n",tag);
+  fflush(stdout);
+  for (n = 0;n < 10000;++n) {
+    for (i = 0;i < 66;++i)
+      x[i] = getchar();
+    for (k = 0;k < NUMPRIMES;++k)
+      doit(x,k);
+  }
+
+  mpz_clears(x_gmp,y_gmp,xy_gmp,z_gmp,twop_gmp,NULL);
+  return 0;
+}
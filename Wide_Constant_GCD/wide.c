@@ -0,0 +1,348 @@
+#include <stdint.h>
+#include <string.h>
+#include "inversewide.h"
+#include "inverse256.h"
+
+typedef __int128 int128;
+
+/* The divstep inversion of portable.c in ../SM2_Constant_GCD, for
+   moduli of up to 384, 448 and 521 bits: a constant-time reference,
+   several times slower than mpz_invert(), not an asm-class engine.
+
+   Numbers are N signed limbs radix 2^62, N = 7, 8, 9: enough for p,
+   for the signed f and g, and for d and e in (-2p,p).  Each round runs
+   62 divsteps on the bottom limbs of f and g and applies the
+   transition matrix, scaled to 2^62, to [f,g] (exactly) and to [d,e]
+   (modulo p), as in portable.c.
+
+   These are the original divsteps, delta starting at 1, kept as
+   theta = -delta so that the swap test is a sign bit.  Bernstein and
+   Yang prove that floor((49b+57)/17) of them (floor((49b+80)/17) for
+   b < 46) take any g < f < 2^b to g = 0: 18, 21 and 25 rounds for
+   384, 448 and 521 bits.  The count depends on the modulus only, so
+   the time does not depend on the input.
+
+   Moduli of up to 192 and 224 bits go to the 256-bit engine of
+   ../SM2_Constant_GCD instead (asm.s with AVX2), whose table sets its
+   round count from the size of p: 8 and 9 rounds of 59 hddivsteps,
+   fewer and cheaper steps than this code would run.  The input is
+   reduced first, since that engine subtracts p only once.
+
+   Table layout (96 entries):
+     0       the width in bytes, 24 28 48 56 or 66
+     1       the number of bits of p
+     2       the number of rounds
+     3       1 for hddivsteps (the 256-bit engine), 0 for divsteps
+     4       1/p mod 2^62
+     8..16   p radix 2^62, N limbs, the rest 0
+     20..28  p radix 2^64, the rest 0
+     32..95  for 24 and 28 bytes, the inverse256 table of p; entries
+             4..16 are 0 then */
+
+#define M62 ((int64_t) (UINT64_MAX>>2))
+
+typedef struct {
+  int64_t u,v,q,r;
+} matrix;
+
+static int64_t divsteps_62(int64_t theta,uint64_t f,uint64_t g,matrix *t)
+{
+  uint64_t u = 1,v = 0,q = 0,r = 1;
+  uint64_t c1,c2,x,y,z;
+  int i;
+
+  for (i = 0;i < 62;++i) {
+    c1 = theta>>63;
+    c2 = -(g&1);
+    x = (f^c1)-c1;
+    y = (u^c1)-c1;
+    z = (v^c1)-c1;
+    g += x&c2;
+    q += y&c2;
+    r += z&c2;
+    c1 &= c2;
+    theta = (theta^c1)-1-c1;
+    f += g&c1;
+    u += q&c1;
+    v += r&c1;
+    g >>= 1;
+    u <<= 1;
+    v <<= 1;
+  }
+  t->u = u;
+  t->v = v;
+  t->q = q;
+  t->r = r;
+  return theta;
+}
+
+/* always inlined into the engines so that N is a constant */
+
+#define INLINE static inline __attribute__((always_inline))
+
+INLINE void update_de(int64_t *d,int64_t *e,const matrix *t,const int64_t *p,int64_t pinv,int n)
+{
+  int64_t sd = d[n-1]>>63,se = e[n-1]>>63;
+  int64_t md = (t->u&sd)+(t->v&se);
+  int64_t me = (t->q&sd)+(t->r&se);
+  int128 cd,ce;
+  int i;
+
+  cd = (int128) t->u*d[0]+(int128) t->v*e[0];
+  ce = (int128) t->q*d[0]+(int128) t->r*e[0];
+  md -= (pinv*(uint64_t) cd+md)&M62;
+  me -= (pinv*(uint64_t) ce+me)&M62;
+  cd += (int128) p[0]*md;
+  ce += (int128) p[0]*me;
+  cd >>= 62;
+  ce >>= 62;
+  for (i = 1;i < n;++i) {
+    cd += (int128) t->u*d[i]+(int128) t->v*e[i]+(int128) p[i]*md;
+    ce += (int128) t->q*d[i]+(int128) t->r*e[i]+(int128) p[i]*me;
+    d[i-1] = (int64_t) cd&M62;
+    e[i-1] = (int64_t) ce&M62;
+    cd >>= 62;
+    ce >>= 62;
+  }
+  d[n-1] = cd;
+  e[n-1] = ce;
+}
+
+INLINE void update_fg(int64_t *f,int64_t *g,const matrix *t,int n)
+{
+  int128 cf,cg;
+  int i;
+
+  cf = (int128) t->u*f[0]+(int128) t->v*g[0];
+  cg = (int128) t->q*f[0]+(int128) t->r*g[0];
+  cf >>= 62;
+  cg >>= 62;
+  for (i = 1;i < n;++i) {
+    cf += (int128) t->u*f[i]+(int128) t->v*g[i];
+    cg += (int128) t->q*f[i]+(int128) t->r*g[i];
+    f[i-1] = (int64_t) cf&M62;
+    g[i-1] = (int64_t) cg&M62;
+    cf >>= 62;
+    cg >>= 62;
+  }
+  f[n-1] = cf;
+  g[n-1] = cg;
+}
+
+INLINE void carry(int64_t *r,int n)
+{
+  int i;
+
+  for (i = 0;i < n-1;++i) {
+    r[i+1] += r[i]>>62;
+    r[i] &= M62;
+  }
+}
+
+INLINE void normalize(int64_t *d,int64_t fsign,const int64_t *p,int n)
+{
+  int64_t mask;
+  int i;
+
+  mask = d[n-1]>>63;
+  for (i = 0;i < n;++i) d[i] += p[i]&mask;
+  mask = fsign>>63;
+  for (i = 0;i < n;++i) d[i] = (d[i]^mask)-mask;
+  carry(d,n);
+  mask = d[n-1]>>63;
+  for (i = 0;i < n;++i) d[i] += p[i]&mask;
+  carry(d,n);
+}
+
+/* w words radix 2^64 to n limbs radix 2^62 and back */
+
+INLINE void to62(int64_t *r,const uint64_t *a,int n,int w)
+{
+  int i,k;
+
+  for (i = 0;i < n;++i) {
+    k = 62*i;
+    r[i] = (k>>6) < w ? a[k>>6]>>(k&63) : 0;
+    if ((k&63) > 2 && (k>>6)+1 < w) r[i] |= a[(k>>6)+1]<<(64-(k&63));
+    if (i < n-1) r[i] &= M62;
+  }
+}
+
+INLINE void from62(uint64_t *a,const int64_t *r,int n,int w)
+{
+  int i,k;
+
+  for (i = 0;i < w;++i) a[i] = 0;
+  for (i = 0;i < n;++i) {
+    k = 62*i;
+    if ((k>>6) < w) a[k>>6] |= (uint64_t) r[i]<<(k&63);
+    if ((k&63) > 2 && (k>>6)+1 < w) a[(k>>6)+1] |= (uint64_t) r[i]>>(64-(k&63));
+  }
+}
+
+/* bytes little-endian into w words, reduced mod p by subtracting p<<k
+   when it fits, k from 8*bytes-bits down to 0; constant time for a
+   given modulus */
+
+INLINE void load(uint64_t *a,const unsigned char *in,const int64_t *table,int bytes,int w)
+{
+  const uint64_t *p = (const uint64_t *) (table+20);
+  uint64_t s[9],t[9];
+  uint64_t borrow,mask;
+  int i,k,j,b;
+
+  for (i = 0;i < w;++i) a[i] = 0;
+  for (i = 0;i < bytes;++i) a[i>>3] |= (uint64_t) in[i]<<(8*(i&7));
+
+  for (k = 8*bytes-table[1];k >= 0;--k) {
+    b = k&63;
+    for (i = 0;i < w;++i) {
+      j = i-(k>>6);
+      s[i] = j >= 0 ? p[j]<<b : 0;
+      if (b && j >= 1) s[i] |= p[j-1]>>(64-b);
+    }
+    borrow = 0;
+    for (i = 0;i < w;++i) {
+      t[i] = a[i]-s[i]-borrow;
+      borrow = (a[i] < s[i]) | ((a[i] == s[i]) & borrow);
+    }
+    mask = borrow-1;
+    for (j = 0;j < w;++j) a[j] ^= (a[j]^t[j])&mask;
+  }
+}
+
+INLINE void store(unsigned char *out,const uint64_t *a,int bytes)
+{
+  int i;
+
+  for (i = 0;i < bytes;++i) out[i] = a[i>>3]>>(8*(i&7));
+}
+
+INLINE void engine(unsigned char *out,const unsigned char *in,const int64_t *table,int bytes,int n)
+{
+  const int w = (bytes+7)/8;
+  int64_t p[9],f[9],g[9],d[9],e[9];
+  int64_t theta = -1,pinv = table[4];
+  uint64_t a[9];
+  matrix t;
+  int i;
+
+  for (i = 0;i < n;++i) p[i] = table[8+i];
+  load(a,in,table,bytes,w);
+  to62(g,a,n,w);
+  for (i = 0;i < n;++i) {
+    f[i] = p[i];
+    d[i] = 0;
+    e[i] = 0;
+  }
+  e[0] = 1;
+
+  for (i = 0;i < table[2];++i) {
+    theta = divsteps_62(theta,f[0],g[0],&t);
+    update_de(d,e,&t,p,pinv,n);
+    update_fg(f,g,&t,n);
+  }
+
+  normalize(d,f[n-1],p,n);
+  from62(a,d,n,w);
+  store(out,a,bytes);
+}
+
+/* reduced, then through inverse256 on the table at 32 */
+
+INLINE void small(unsigned char *out,const unsigned char *in,const int64_t *table,int bytes)
+{
+  uint64_t a[4],b[4];
+
+  load(a,in,table,bytes,4);
+  inverse256_limbs(b,a,table+32);
+  store(out,b,bytes);
+}
+
+void inverse192(unsigned char *out,const unsigned char *in,const int64_t *table)
+{
+  small(out,in,table,24);
+}
+
+void inverse224(unsigned char *out,const unsigned char *in,const int64_t *table)
+{
+  small(out,in,table,28);
+}
+
+void inverse384(unsigned char *out,const unsigned char *in,const int64_t *table)
+{
+  engine(out,in,table,48,7);
+}
+
+void inverse448(unsigned char *out,const unsigned char *in,const int64_t *table)
+{
+  engine(out,in,table,56,8);
+}
+
+void inverse521(unsigned char *out,const unsigned char *in,const int64_t *table)
+{
+  engine(out,in,table,66,9);
+}
+
+void inversewide(unsigned char *out,const unsigned char *in,const int64_t *table)
+{
+  switch (table[0]) {
+    case 24: inverse192(out,in,table); break;
+    case 28: inverse224(out,in,table); break;
+    case 48: inverse384(out,in,table); break;
+    case 56: inverse448(out,in,table); break;
+    case 66: inverse521(out,in,table); break;
+  }
+}
+
+int inversewide_table_init(int64_t *table,const unsigned char *modulus,long long bytes)
+{
+  uint64_t p[9],pinv,top;
+  unsigned char p256[32];
+  long long i,k,n,bits;
+
+  if (bytes == 24 || bytes == 28) n = 0;
+  else if (bytes == 48) n = 7;
+  else if (bytes == 56) n = 8;
+  else if (bytes == 66) n = 9;
+  else return -1;
+
+  for (i = 0;i < 9;++i) p[i] = 0;
+  for (i = 0;i < bytes;++i) p[i>>3] |= (uint64_t) modulus[i]<<(8*(i&7));
+
+  if (!(p[0]&1)) return -1;
+  top = 0;
+  for (i = 1;i < 9;++i) top |= p[i];
+  if (p[0] == 1 && !top) return -1;
+
+  bits = 0;
+  for (i = 0;i < 64*9;++i)
+    if ((p[i>>6]>>(i&63))&1) bits = i+1;
+  if (bits > 521) return -1;
+
+  /* Newton iteration as in generic.c */
+  pinv = p[0];
+  for (i = 0;i < 5;++i) pinv *= 2-p[0]*pinv;
+
+  for (i = 0;i < 96;++i) table[i] = 0;
+  table[0] = bytes;
+  table[1] = bits;
+  for (i = 0;i < 9;++i) table[20+i] = p[i];
+  if (!n) {
+    memset(p256,0,32);
+    memcpy(p256,modulus,bytes);
+    if (inverse256_table_init(table+32,p256) != 0) return -1;
+    table[2] = table[32+61];
+    table[3] = 1;
+    return 0;
+  }
+  table[2] = ((49*bits+(bits < 46 ? 80 : 57))/17+61)/62;
+  table[4] = pinv&M62;
+  for (i = 0;i < n;++i) {
+    k = 62*i;
+    table[8+i] = p[k>>6]>>(k&63);
+    if ((k&63) > 2 && (k>>6) < 8) table[8+i] |= p[(k>>6)+1]<<(64-(k&63));
+    table[8+i] &= M62;
+  }
+  return 0;
+}
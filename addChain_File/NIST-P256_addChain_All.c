@@ -1,86 +1,50 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <unistd.h>
 #include <gmp.h>
-#include <fcntl.h>
-#include <sys/stat.h>
-#include <sys/types.h>
 #include <time.h>
+#include "fe256.h"
 
 #define BITS 256
 #define P_HEX "ffffffff00000001000000000000000000000000ffffffffffffffffffffffff"
 
+// The chain itself is fe256_p256_invert() in fe256.c, on fixed 4x64-bit
+// limbs with no allocation; this only converts from and to mpz.
 void fermat_inversion(mpz_t t, const mpz_t z, const mpz_t p) {
-    mpz_t z3, z15, t0, t1, t2, t3, t4, t5, temp;
-    mpz_inits(z3, z15, t0, t1, t2, t3, t4, t5, temp, NULL);
+    fe256 zf, tf;
 
-    // z3 = z^2 * z
-    mpz_pow_ui(z3, z, 2);
-    mpz_mul(z3, z3, z);
-
-    // z15 = z3^(2^2) * z3
-    mpz_powm_ui(z15, z3, 4, p);
-    mpz_mul(z15, z15, z3);
-
-    // t0 = z15^(2^2) * z3
-    mpz_powm_ui(t0, z15, 4, p);
-    mpz_mul(t0, t0, z3);
-
-    // t1 = t0^(2^6) * t0
-    for (int i = 0; i < 6; ++i) {
-        mpz_powm_ui(t1, t0, 2, p);
-    }
-    mpz_mul(t1, t1, t0);
-
-    // t2 = ((t1^(2^12) * t1)^(2^6)) * t0
-    for (int i = 0; i < 12; ++i) {
-        mpz_powm_ui(temp, t1, 2, p);
-    }
-    mpz_mul(temp, temp, t1);
-    mpz_powm_ui(t2, temp, 64, p);
-    mpz_mul(t2, t2, t0);
-
-    // t3 = t2^2 * z3
-    mpz_powm_ui(t3, t2, 2, p);
-    mpz_mul(t3, t3, z3);
-
-    // t4 = ((t3^(2^32) * z)^(2^96))
-    for (int i = 0; i < 32; ++i) {
-        mpz_powm_ui(temp, t3, 2, p);
-    }
+    memset(zf, 0, sizeof zf);
+    mpz_export(zf, NULL, -1, 8, 0, 0, z);
+    fe256_p256_invert(tf, zf);
+    mpz_import(t, 4, -1, 8, 0, 0, tf);
+}
 
-    mpz_mul(temp, temp, z);
-    mpz_powm_ui(t4, temp, 2, p);
-    for (int i = 0; i < 96; ++i) {
-        mpz_powm_ui(t4, t4, 2, p);
-    }
+// rdtsc, for setting the chain against the safegcd asm cycle for cycle
+static long long cpucycles(void) {
+    unsigned int lo, hi;
+    __asm__ volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((long long) hi << 32) | lo;
+}
 
-    // t5 = (t4^(2^32) * t3)^(2^32) * t3
-    for (int i = 0; i < 32; ++i) {
-        mpz_powm_ui(temp, t4, 2, p);
-    }
-    mpz_mul(temp, temp, t3);
-    for (int i = 0; i < 96; ++i) {
-        mpz_powm_ui(t5, temp, 2, p);
-    }
-    mpz_mul(t5, t5, t3);
-    for (int i = 0; i < 32; ++i) {
-        mpz_powm_ui(t5, t5, 2, p);
-    }
+static int cmp_ll(const void *a, const void *b) {
+    long long x = *(const long long *) a, y = *(const long long *) b;
+    return (x > y) - (x < y);
+}
 
-    // t = (t5^(2^30) * t2)^(2^2) * z
-    for (int i = 0; i < 30; ++i) {
-        mpz_powm_ui(temp, t5, 2, p);
+// median cycles of the field-level chain alone, without the mpz conversion
+static long long bench_chain(const mpz_t z) {
+    long long c[1024];
+    fe256 f;
+
+    memset(f, 0, sizeof f);
+    mpz_export(f, NULL, -1, 8, 0, 0, z);
+    for (int i = 0; i < 1024; ++i) {
+        c[i] = cpucycles();
+        fe256_p256_invert(f, f);
+        c[i] = cpucycles() - c[i];
     }
-
-    mpz_mul(temp, temp, t2);
-    mpz_powm_ui(t, temp, 4, p);
-    mpz_mul(t, t, z);
-
-      // Print the result in hexadecimal format
-    gmp_printf("z = %ZX\n", z);
-    gmp_printf("t = %ZX\n\n", t);
+    qsort(c, 1024, sizeof c[0], cmp_ll);
+    return c[512];
 }
 
 int main() {
@@ -101,6 +65,11 @@ int main() {
     // Initialize buffer for reading from /dev/random
     unsigned char buf[BITS/8];
 
+    // Every result is checked against mpz_invert
+    mpz_t check;
+    mpz_init(check);
+    int mismatches = 0;
+
     // Start measuring time
     clock_t start = clock();
 
@@ -122,6 +91,8 @@ int main() {
 
         // Calculate Fermat-based inversion
         fermat_inversion(t, z, p);
+        if (!mpz_invert(check, z, p)) mpz_set_ui(check, 0);
+        if (mpz_cmp(check, t) != 0) ++mismatches;
 
         // Print the result in hexadecimal format
         gmp_printf("z = %ZX\n", z);
@@ -134,11 +105,19 @@ int main() {
     // Calculate and print time elapsed
     double time_elapsed = (double) (end - start) / CLOCKS_PER_SEC;
     printf("Time elapsed: %f seconds\n", time_elapsed);
+    printf("Cycles per inversion (median): %lld\n", bench_chain(z));
+    printf("Results differing from mpz_invert: %d\n", mismatches);
+#ifdef FE256_COUNT
+    fe256_count_sqr = fe256_count_mul = 0;
+    fermat_inversion(t, z, p);
+    printf("Operations per inversion: %lluS + %lluM\n", fe256_count_sqr, fe256_count_mul);
+#endif
 
     // Clean up GMP variables
     mpz_clear(p);
     mpz_clear(z);
     mpz_clear(t);
+    mpz_clear(check);
 
-    return 0;
+    return mismatches != 0;
 }
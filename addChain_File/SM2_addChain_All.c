@@ -1,87 +1,50 @@
 #include <stdio.h>
-#include <stdint.h>
 #include <gmp.h>
-#include <fcntl.h>
-#include <unistd.h>
-#include <errno.h>
 #include <time.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fe256.h"
 
 #define p "0xFFFFFFFEFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF00000000FFFFFFFFFFFFFFFF"
 
 // Fermat 模逆算法计算给定值 z 在模 p 下的逆元 t
+// 加法链本身是 fe256.c 中的 fe256_sm2_invert(), 运行在固定的 4x64 位 limb 上, 不分配内存;
+// 这里只负责 mpz 与 fe256 之间的转换
 void fermat_invert(mpz_t t, mpz_t z, mpz_t p_mpz) {
-    mpz_t z3, z15, t0, t1, t2, t3, t4, t5;
-    mpz_init(z3);
-    mpz_init(z15);
-    mpz_init(t0);
-    mpz_init(t1);
-    mpz_init(t2);
-    mpz_init(t3);
-    mpz_init(t4);
-    mpz_init(t5);
-
-    mpz_mul(z3, z, z);
-    mpz_mul(z3, z3, z);
-    mpz_powm_ui(z15, z3, 4, p_mpz);
-    mpz_powm_ui(t0, z15, 4, p_mpz);
-
-    mpz_powm_ui(t1, t0, 64, p_mpz);
-
-    // 循环计算 t1 的 2 的次方
-    for (int i = 0; i < 6; ++i) {
-        mpz_powm_ui(t1, t1, 2, p_mpz);
-    }
-
-    mpz_mul(t1, t1, t0);
-
-    mpz_powm_ui(t2, t1, 2, p_mpz);
-
-    // 循环计算 t2 的 2 的次方
-    for (int i = 0; i < 12; ++i) {
-        mpz_powm_ui(t2, t2, 2, p_mpz);
-    }
-
-    mpz_mul(t2, t2, t1);
-    mpz_mul(t2, t2, z15);
-
-    mpz_powm_ui(t3, t2, 2, p_mpz);
-    mpz_mul(t3, t3, z3);
-
-    mpz_powm_ui(t4, t3, 2, p_mpz);
-
-    // 循环计算 t4 的 2 的次方
-    for (int i = 0; i < 32; ++i) {
-        mpz_powm_ui(t4, t4, 2, p_mpz);
-    }
+    fe256 zf, tf;
 
-    mpz_mul(t4, t4, t3);
-    mpz_powm_ui(t4, t4, 96, p_mpz);
+    memset(zf, 0, sizeof zf);
+    mpz_export(zf, NULL, -1, 8, 0, 0, z);
+    fe256_sm2_invert(tf, zf);
+    mpz_import(t, 4, -1, 8, 0, 0, tf);
+}
 
-    mpz_powm_ui(t5, t4, 32, p_mpz);
-    mpz_mul(t5, t5, t3);
+// rdtsc, 用于与 safegcd asm 逐周期比较
+static long long cpucycles(void) {
+    unsigned int lo, hi;
+    __asm__ volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((long long) hi << 32) | lo;
+}
 
-    // 循环计算 t5 的 2 的次方
-    for (int i = 0; i < 32; ++i) {
-        mpz_powm_ui(t5, t5, 2, p_mpz);
-    }
+static int cmp_ll(const void *a, const void *b) {
+    long long x = *(const long long *) a, y = *(const long long *) b;
+    return (x > y) - (x < y);
+}
 
-    // 循环计算 t5 的 2 的次方
-    for (int i = 0; i < 2; ++i) {
-        mpz_powm_ui(t5, t5, 2, p_mpz);
+// 仅加法链本身 (不含 mpz 转换) 的周期中位数
+static long long bench_chain(mpz_t z) {
+    long long c[1024];
+    fe256 f;
+
+    memset(f, 0, sizeof f);
+    mpz_export(f, NULL, -1, 8, 0, 0, z);
+    for (int i = 0; i < 1024; ++i) {
+        c[i] = cpucycles();
+        fe256_sm2_invert(f, f);
+        c[i] = cpucycles() - c[i];
     }
-
-    mpz_mul(t, t5, z);
-    mpz_sub(t, p_mpz, t);
-
-    // 清理 mpz_t 变量
-    mpz_clear(z3);
-    mpz_clear(z15);
-    mpz_clear(t0);
-    mpz_clear(t1);
-    mpz_clear(t2);
-    mpz_clear(t3);
-    mpz_clear(t4);
-    mpz_clear(t5);
+    qsort(c, 1024, sizeof c[0], cmp_ll);
+    return c[512];
 }
 
 
@@ -91,17 +54,16 @@ int main() {
     mpz_init(z);
     mpz_init(t);
 
-    int randomData = open("/dev/urandom", O_RDONLY);
-    if (randomData < 0) {
-        perror("Error: failed to open /dev/urandom");
-        return -1;
-    }
-
     // Start measuring time
     clock_t start = clock();
 
     int i = 5000;
 
+    // 每个结果都与 mpz_invert 对比
+    mpz_t check;
+    mpz_init(check);
+    int mismatches = 0;
+
     // 生成 1 到 p-1 之间的随机数
     gmp_randstate_t rand_state;
     gmp_randinit_default(rand_state);
@@ -113,6 +75,8 @@ int main() {
 
         // 计算 z 在模 p 下的逆元
         fermat_invert(t, z, p_mpz);
+        if (!mpz_invert(check, z, p_mpz)) mpz_set_ui(check, 0);
+        if (mpz_cmp(check, t) != 0) ++mismatches;
         gmp_printf("t = %Zx\n\n", t);
     }
 
@@ -123,12 +87,19 @@ int main() {
     // Calculate and print time elapsed
     double time_elapsed = (double)(end - start) / CLOCKS_PER_SEC;
     printf("Time elapsed: %f seconds\n", time_elapsed);
+    printf("Cycles per inversion (median): %lld\n", bench_chain(z));
+    printf("Results differing from mpz_invert: %d\n", mismatches);
+#ifdef FE256_COUNT
+    fe256_count_sqr = fe256_count_mul = 0;
+    fermat_invert(t, z, p_mpz);
+    printf("Operations per inversion: %lluS + %lluM\n", fe256_count_sqr, fe256_count_mul);
+#endif
 
-    close(randomData);
     mpz_clear(p_mpz);
     mpz_clear(z);
     mpz_clear(t);
+    mpz_clear(check);
 
-    return 0;
+    return mismatches != 0;
 }
 
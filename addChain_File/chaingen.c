@@ -0,0 +1,411 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gmp.h>
+
+// Addition-chain generator: for each modulus p, search for a short
+// chain for z^(p-2) and print it as a straight-line C function
+// fermat_inverse_<name>() over fe256.
+//
+//   ./chaingen c > fermat_inverse.c
+//   ./chaingen h > fermat_inverse.h
+//
+// covers the built-in moduli below; "./chaingen c|h <name> <hex>" does
+// the same for one other odd modulus below 2^256.
+//
+//   ./chaingen -s c > sqrt256.c
+//   ./chaingen -s h > sqrt256.h
+//
+// prints square roots instead, sqrt256_<name>() by the chain for
+// z^((p+1)/4), for the built-in moduli with p = 3 mod 4.
+//
+// The exponent is cut, from the top, into runs of ones and windows.  A
+// run of at least r ones is taken in blocks of b ones, each block
+// x_b = z^(2^b - 1) built from shorter runs (x_a^(2^(b-a)) * x_(b-a));
+// any other 1-bit starts a window of up to k bits, an odd power z^w
+// from the table z, z^3, ..., z^(2^k - 1).  The chain then shifts
+// each piece in with squarings.  Every (k, r, b) is tried and the one
+// with the fewest squarings plus multiplications is printed.
+
+typedef struct {
+    const char *name;
+    const char *hex;
+    const char *solinas; // fe256_<solinas>_* for P-256 and SM2, 0 for fe256_mont_*
+} modulus;
+
+static const modulus builtin[] = {
+    { "sm2_p", "fffffffeffffffffffffffffffffffffffffffff00000000ffffffffffffffff", "sm2" },
+    { "sm2_n", "fffffffeffffffffffffffffffffffff7203df6b21c6052b53bbf40939d54123", 0 },
+    { "P256_p", "ffffffff00000001000000000000000000000000ffffffffffffffffffffffff", "p256" },
+    { "P256_n", "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632551", 0 },
+    { "BTC_p", "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f", 0 },
+    { "BTC_n", "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141", 0 },
+    { "25519", "7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffed", 0 },
+};
+
+#define MAXOPS 2048
+#define MAXVARS 512
+
+enum { SQR_N, MUL };
+
+typedef struct {
+    int kind;
+    int dst, a, b; // dst = a^(2^b) for SQR_N, a * b for MUL
+} op;
+
+typedef struct {
+    op ops[MAXOPS];
+    int nops;
+    char names[MAXVARS][16];
+    int nvars;
+    int odd[64];  // variable holding z^w, w odd, or -1
+    int run[257]; // variable holding z^(2^L - 1), or -1
+    int z2;       // z^2, or -1
+    int sqrs, muls;
+    int k, r, b, s;
+} chain;
+
+static mpz_t e;
+static int ebits;
+
+static int newvar(chain *c, const char *fmt, int n)
+{
+    snprintf(c->names[c->nvars], sizeof c->names[0], fmt, n);
+    return c->nvars++;
+}
+
+static void emit(chain *c, int kind, int dst, int a, int b)
+{
+    op *o = &c->ops[c->nops++];
+
+    o->kind = kind;
+    o->dst = dst;
+    o->a = a;
+    o->b = b;
+    if (kind == SQR_N) c->sqrs += b;
+    else c->muls += 1;
+}
+
+static void reset(chain *c)
+{
+    int i;
+
+    c->nops = 0;
+    c->nvars = 0;
+    c->sqrs = c->muls = 0;
+    for (i = 0; i < 64; ++i) c->odd[i] = -1;
+    for (i = 0; i < 257; ++i) c->run[i] = -1;
+    c->odd[1] = c->run[1] = newvar(c, "z", 0);
+    c->z2 = -1;
+}
+
+static int getodd(chain *c, int w)
+{
+    int v;
+
+    if (c->odd[w] >= 0) return c->odd[w];
+    if (c->z2 < 0) {
+        c->z2 = newvar(c, "z2", 0);
+        emit(c, SQR_N, c->z2, c->odd[1], 1);
+    }
+    v = getodd(c, w - 2);
+    c->odd[w] = newvar(c, "z%d", w);
+    emit(c, MUL, c->odd[w], v, c->z2);
+    return c->odd[w];
+}
+
+// x_L from two runs that already exist if possible, else from halves
+// (s = 0) or by doubling the longest run so far and adding what is left
+// (s = 1)
+static int getrun(chain *c, int L)
+{
+    int a, x, y, v;
+
+    if (c->run[L] >= 0) return c->run[L];
+    if (L < 7 && c->odd[(1 << L) - 1] >= 0) return c->run[L] = c->odd[(1 << L) - 1];
+
+    for (a = L - 1; 2 * a >= L; --a)
+        if (c->run[a] >= 0 && c->run[L - a] >= 0) break;
+    if (2 * a < L) {
+        if (c->s) {
+            for (a = L - 1; c->run[a] < 0; --a);
+            for (; 2 * a < L; a *= 2) getrun(c, 2 * a);
+        } else a = L - L / 2;
+    }
+    x = getrun(c, a);
+    y = getrun(c, L - a);
+
+    v = L < 7 ? newvar(c, "z%d", (1 << L) - 1) : newvar(c, "x%d", L);
+    emit(c, SQR_N, v, x, L - a);
+    emit(c, MUL, v, v, y);
+    c->run[L] = v;
+    if (L < 7) c->odd[(1 << L) - 1] = v;
+    return v;
+}
+
+typedef struct {
+    int isrun, n; // run of n ones, or odd power z^n
+    int low;      // exponent bit of its lowest bit
+} piece;
+
+static int cut(piece *pc, int k, int r, int b)
+{
+    int i = ebits - 1, j, L, n = 0, w;
+
+    while (i >= 0) {
+        if (!mpz_tstbit(e, i)) {
+            --i;
+            continue;
+        }
+        for (L = 0; i - L >= 0 && mpz_tstbit(e, i - L); ++L);
+        if (L >= r) {
+            while (L > 0) {
+                pc[n].isrun = 1;
+                pc[n].n = L < b ? L : b;
+                pc[n].low = i - pc[n].n + 1;
+                i -= pc[n].n;
+                L -= pc[n].n;
+                ++n;
+            }
+            continue;
+        }
+        j = i - k + 1;
+        if (j < 0) j = 0;
+        while (!mpz_tstbit(e, j)) ++j;
+        for (w = 0, L = i; L >= j; --L) w = 2 * w + mpz_tstbit(e, L);
+        pc[n].isrun = 0;
+        pc[n].n = w;
+        pc[n].low = j;
+        i = j - 1;
+        ++n;
+    }
+    return n;
+}
+
+static void build(chain *c, int k, int r, int b, int s)
+{
+    piece pc[260];
+    char need[257];
+    int n, i, L, t, v, src;
+
+    reset(c);
+    c->k = k;
+    c->r = r;
+    c->b = b;
+    c->s = s;
+    n = cut(pc, k, r, b);
+
+    // shorter runs first, so longer ones can be made from them
+    memset(need, 0, sizeof need);
+    for (i = 0; i < n; ++i)
+        if (pc[i].isrun) need[pc[i].n] = 1;
+    for (L = 1; L <= 256; ++L)
+        if (need[L]) getrun(c, L);
+    for (i = 0; i < n; ++i)
+        if (!pc[i].isrun) getodd(c, pc[i].n);
+
+    t = newvar(c, "t", 0);
+    src = pc[0].isrun ? c->run[pc[0].n] : c->odd[pc[0].n];
+    for (i = 1; i < n; ++i) {
+        v = pc[i].isrun ? c->run[pc[i].n] : c->odd[pc[i].n];
+        emit(c, SQR_N, t, src, pc[i - 1].low - pc[i].low);
+        emit(c, MUL, t, t, v);
+        src = t;
+    }
+    if (src != t || pc[n - 1].low) emit(c, SQR_N, t, src, pc[n - 1].low);
+}
+
+// the chain for the exponent now in e
+static void search(chain *best)
+{
+    static chain c;
+    int k, r, b, s;
+
+    ebits = mpz_sizeinbase(e, 2);
+
+    best->nops = -1;
+    for (k = 1; k <= 6; ++k)
+        for (r = 2; r <= 32; ++r)
+            for (b = r; b <= 256; ++b)
+            for (s = 0; s < 2; ++s) {
+                build(&c, k, r, b, s);
+                if (best->nops < 0 || c.sqrs + c.muls < best->sqrs + best->muls
+                    || (c.sqrs + c.muls == best->sqrs + best->muls && c.nvars < best->nvars))
+                    *best = c;
+            }
+}
+
+static void limbs(FILE *f, mpz_t x)
+{
+    uint64_t w[4] = { 0, 0, 0, 0 };
+
+    mpz_export(w, 0, -1, 8, 0, 0, x);
+    fprintf(f, "{ 0x%016llxULL, 0x%016llxULL, 0x%016llxULL, 0x%016llxULL }",
+        (unsigned long long) w[0], (unsigned long long) w[1],
+        (unsigned long long) w[2], (unsigned long long) w[3]);
+}
+
+static void header(const modulus *m, const chain *c, int sqrt)
+{
+    int extra = 2;
+
+    printf("\n// p = 0x%s\n", m->hex);
+    if (sqrt) {
+        printf("#define sqrt256_%s_sqrs %d\n", m->name, c->sqrs + 1);
+        printf("#define sqrt256_%s_muls %d\n", m->name, c->muls + extra);
+        printf("int sqrt256_%s(fe256 h, const fe256 z);\n", m->name);
+        printf("void sqrt256_%s_batch(fe256 *h, int *found, const fe256 *z, long long n);\n", m->name);
+        return;
+    }
+    printf("#define fermat_inverse_%s_sqrs %d\n", m->name, c->sqrs);
+    printf("#define fermat_inverse_%s_muls %d\n", m->name, c->muls + extra);
+    printf("void fermat_inverse_%s(fe256 h, const fe256 z);\n", m->name);
+}
+
+static void function(const modulus *m, const chain *c, int sqrt)
+{
+    static chain d;
+    char mul[64], sqr[64], sqr_n[64], in[64], out[64], ctx[32];
+    const op *o;
+    int i;
+    mpz_t p, x;
+
+    if (m->solinas) {
+        snprintf(mul, sizeof mul, "fe256_%s_mul", m->solinas);
+        snprintf(sqr, sizeof sqr, "fe256_%s_sqr", m->solinas);
+        snprintf(sqr_n, sizeof sqr_n, "fe256_%s_sqr_n", m->solinas);
+        snprintf(in, sizeof in, "fe256_%s_in", m->solinas);
+        snprintf(out, sizeof out, "fe256_%s_out", m->solinas);
+        ctx[0] = 0;
+    } else {
+        strcpy(mul, "fe256_mont_mul");
+        strcpy(sqr, "fe256_mont_sqr");
+        strcpy(sqr_n, "fe256_mont_sqr_n");
+        strcpy(in, "fe256_mont_in");
+        strcpy(out, "fe256_mont_out");
+        snprintf(ctx, sizeof ctx, ", &m_%s", m->name);
+
+        mpz_inits(p, x, NULL);
+        mpz_set_str(p, m->hex, 16);
+        printf("\nstatic const fe256_modulus m_%s = {\n    ", m->name);
+        limbs(stdout, p);
+        mpz_set_ui(x, 0);
+        mpz_setbit(x, 64);
+        mpz_invert(x, p, x);
+        mpz_ui_sub(x, 0, x);
+        mpz_fdiv_r_2exp(x, x, 64);
+        printf(",\n    0x%016llxULL,\n    ", (unsigned long long) mpz_get_ui(x));
+        mpz_set_ui(x, 0);
+        mpz_setbit(x, 512);
+        mpz_mod(x, x, p);
+        limbs(stdout, x);
+        printf("\n};\n");
+        mpz_clears(p, x, NULL);
+    }
+
+    // z itself stays in standard form; the chain starts from zm = z 2^256
+    d = *c;
+    strcpy(d.names[0], "zm");
+    c = &d;
+
+    printf("\n// windows of %d bits, runs of %d or more ones in blocks of %d: %dS + %dM\n",
+        c->k, c->r, c->b, c->sqrs, c->muls);
+    if (sqrt) printf("int sqrt256_%s(fe256 h, const fe256 z)\n{\n", m->name);
+    else printf("void fermat_inverse_%s(fe256 h, const fe256 z)\n{\n", m->name);
+    printf("    fe256 ");
+    for (i = 0; i < c->nvars; ++i)
+        printf("%s%s", c->names[i], i + 1 < c->nvars ? ", " : sqrt ? ", s;\n" : ";\n\n");
+    if (sqrt) printf("    int found;\n\n");
+    printf("    %s(zm, z%s);\n", in, ctx);
+
+    for (i = 0; i < c->nops; ++i) {
+        o = &c->ops[i];
+        if (o->kind == MUL)
+            printf("    %s(%s, %s, %s%s);\n", mul, c->names[o->dst], c->names[o->a], c->names[o->b], ctx);
+        else if (o->b == 1)
+            printf("    %s(%s, %s%s);\n", sqr, c->names[o->dst], c->names[o->a], ctx);
+        else
+            printf("    %s(%s, %s, %d%s);\n", sqr_n, c->names[o->dst], c->names[o->a], o->b, ctx);
+    }
+
+    if (sqrt) {
+        // t^2 = z exactly when z is a square; s is compared in the same
+        // domain as the chain ran, before h (which may be z) is written
+        printf("    %s(s, t%s);\n", sqr, ctx);
+        printf("    found = equal(s, %s);\n", c->names[0]);
+        printf("    %s(h, t%s);\n", out, ctx);
+        printf("    return found;\n}\n");
+
+        printf("\nvoid sqrt256_%s_batch(fe256 *h, int *found, const fe256 *z, long long n)\n{\n", m->name);
+        printf("    long long i;\n\n");
+        printf("    for (i = 0; i < n; ++i) found[i] = sqrt256_%s(h[i], z[i]);\n}\n", m->name);
+    } else printf("    %s(h, t%s);\n}\n", out, ctx);
+}
+
+int main(int argc, char **argv)
+{
+    static chain c;
+    modulus one;
+    const modulus *list = builtin;
+    int n = sizeof builtin / sizeof builtin[0];
+    int i, sqrt = 0;
+
+    if (argc > 1 && !strcmp(argv[1], "-s")) {
+        sqrt = 1;
+        --argc;
+        ++argv;
+    }
+    if ((argc != 2 && argc != 4) || (argv[1][0] != 'c' && argv[1][0] != 'h')) {
+        fprintf(stderr, "usage: chaingen [-s] c|h [name hex]\n");
+        return 1;
+    }
+    if (argc == 4) {
+        one.name = argv[2];
+        one.hex = argv[3];
+        one.solinas = 0;
+        list = &one;
+        n = 1;
+    }
+
+    mpz_init(e);
+    printf("// generated by chaingen; do not edit\n");
+    if (argv[1][0] == 'h' && sqrt) printf("\n#ifndef SQRT256_H\n#define SQRT256_H\n\n#include \"fe256.h\"\n\n"
+        "// For 0 <= z < p, p = 3 mod 4: h = z^((p+1)/4) mod p, and the return\n"
+        "// value is 1 if h^2 = z (z is a square, 0 included, and h one of its\n"
+        "// roots) or 0 (z is not a square, and h^2 = -z).  Constant time; h may\n"
+        "// be z.  The _batch forms take n of them with a flag each.  The _sqrs\n"
+        "// count includes the check squaring, the _muls the two Montgomery\n"
+        "// conversions.\n");
+    else if (argv[1][0] == 'h') printf("\n#ifndef FERMAT_INVERSE_H\n#define FERMAT_INVERSE_H\n\n#include \"fe256.h\"\n\n"
+        "// h = z^(p-2) mod p = 1/z for 0 <= z < p.  The _muls counts include\n"
+        "// the two Montgomery conversions.\n");
+    else if (sqrt) printf("\n#include \"sqrt256.h\"\n\n"
+        "// 1 if f = g, without branching on either\n"
+        "static int equal(const fe256 f, const fe256 g)\n{\n"
+        "    uint64_t d = (f[0] ^ g[0]) | (f[1] ^ g[1]) | (f[2] ^ g[2]) | (f[3] ^ g[3]);\n\n"
+        "    return (int) (((d | (0 - d)) >> 63) ^ 1);\n}\n");
+    else printf("\n#include \"fermat_inverse.h\"\n");
+
+    for (i = 0; i < n; ++i) {
+        mpz_set_str(e, list[i].hex, 16);
+        if (sqrt) {
+            if (mpz_fdiv_ui(e, 4) != 3) {
+                if (list == &one) {
+                    fprintf(stderr, "chaingen: %s: p is not 3 mod 4\n", one.name);
+                    return 1;
+                }
+                continue;
+            }
+            mpz_add_ui(e, e, 1);
+            mpz_fdiv_q_2exp(e, e, 2);
+        } else mpz_sub_ui(e, e, 2);
+        search(&c);
+        if (argv[1][0] == 'h') header(&list[i], &c, sqrt);
+        else function(&list[i], &c, sqrt);
+    }
+
+    if (argv[1][0] == 'h') printf("\n#endif\n");
+    mpz_clear(e);
+    return 0;
+}
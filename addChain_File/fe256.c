@@ -0,0 +1,421 @@
+#include <string.h>
+#include <x86intrin.h>
+#include "fe256.h"
+
+typedef unsigned __int128 uint128;
+
+static const uint64_t p256[4] = {
+    0xffffffffffffffffULL, 0x00000000ffffffffULL,
+    0x0000000000000000ULL, 0xffffffff00000001ULL
+};
+
+static const uint64_t sm2[4] = {
+    0xffffffffffffffffULL, 0xffffffff00000000ULL,
+    0xffffffffffffffffULL, 0xfffffffeffffffffULL
+};
+
+#ifdef FE256_COUNT
+unsigned long long fe256_count_mul, fe256_count_sqr;
+#define COUNT(x) (++fe256_count_##x)
+#else
+#define COUNT(x)
+#endif
+
+// p + 1, whose low limb is 0, and 2^512 mod p to enter the
+// Montgomery domain
+static const uint64_t p256_1[4] = {
+    0x0000000000000000ULL, 0x0000000100000000ULL,
+    0x0000000000000000ULL, 0xffffffff00000001ULL
+};
+
+static const uint64_t p256_rr[4] = {
+    0x0000000000000003ULL, 0xfffffffbffffffffULL,
+    0xfffffffffffffffeULL, 0x00000004fffffffdULL
+};
+
+static const uint64_t sm2_1[4] = {
+    0x0000000000000000ULL, 0xffffffff00000001ULL,
+    0xffffffffffffffffULL, 0xfffffffeffffffffULL
+};
+
+static const uint64_t sm2_rr[4] = {
+    0x0000000200000003ULL, 0x00000002ffffffffULL,
+    0x0000000100000001ULL, 0x0000000400000002ULL
+};
+
+// c = f * g, 512 bits
+static void mul512(uint64_t *c, const uint64_t *f, const uint64_t *g)
+{
+    uint128 t;
+    uint64_t carry;
+    int i, j;
+
+    for (i = 0; i < 8; ++i) c[i] = 0;
+    for (i = 0; i < 4; ++i) {
+        carry = 0;
+        for (j = 0; j < 4; ++j) {
+            t = (uint128) f[i] * g[j] + c[i + j] + carry;
+            c[i + j] = (uint64_t) t;
+            carry = (uint64_t) (t >> 64);
+        }
+        c[i + 4] = carry;
+    }
+}
+
+// c = f^2, 512 bits: the 6 cross products once, doubled, plus the 4 squares
+static void sqr512(uint64_t *c, const uint64_t *f)
+{
+    uint128 t;
+    uint64_t carry;
+    int i, j;
+
+    for (i = 0; i < 8; ++i) c[i] = 0;
+    for (i = 0; i < 3; ++i) {
+        carry = 0;
+        for (j = i + 1; j < 4; ++j) {
+            t = (uint128) f[i] * f[j] + c[i + j] + carry;
+            c[i + j] = (uint64_t) t;
+            carry = (uint64_t) (t >> 64);
+        }
+        c[i + 4] = carry;
+    }
+
+    carry = 0;
+    for (i = 0; i < 8; ++i) {
+        uint64_t top = c[i] >> 63;
+        c[i] = (c[i] << 1) | carry;
+        carry = top;
+    }
+
+    carry = 0;
+    for (i = 0; i < 4; ++i) {
+        t = (uint128) f[i] * f[i] + c[2 * i] + carry;
+        c[2 * i] = (uint64_t) t;
+        t = (uint128) c[2 * i + 1] + (uint64_t) (t >> 64);
+        c[2 * i + 1] = (uint64_t) t;
+        carry = (uint64_t) (t >> 64);
+    }
+}
+
+typedef unsigned long long limb;
+
+// h = c / 2^256 mod p, for c < p 2^256 and p = -1 mod 2^64.  Then
+// -1/p = 1 mod 2^64, so each quotient digit q is the low limb itself,
+// and c + q p = (c - q) + q (p + 1) clears it without a borrow and
+// with only the three upper limbs of p + 1 to multiply.  Each row
+// goes in with one add/adc chain (which uint128 sums do not reliably
+// compile to), its carry riding on the next row's top limb; the
+// result is below 2p, and one conditional subtraction finishes.
+static inline void redc(fe256 h, const uint64_t *c, const uint64_t *p, const uint64_t *p1)
+{
+    limb t[8], r[4], lo[4], hi[4], carry, mask;
+    unsigned char a;
+    uint128 x;
+    int i, j;
+
+    for (i = 0; i < 8; ++i) t[i] = c[i];
+    carry = 0;
+    for (i = 0; i < 4; ++i) {
+        for (j = 1; j < 4; ++j) {
+            x = (uint128) t[i] * p1[j];
+            lo[j] = (uint64_t) x;
+            hi[j] = (uint64_t) (x >> 64);
+        }
+        a = _addcarry_u64(0, lo[2], hi[1], &lo[2]);
+        a = _addcarry_u64(a, lo[3], hi[2], &lo[3]);
+        hi[3] += a + carry;
+        a = _addcarry_u64(0, t[i + 1], lo[1], &t[i + 1]);
+        a = _addcarry_u64(a, t[i + 2], lo[2], &t[i + 2]);
+        a = _addcarry_u64(a, t[i + 3], lo[3], &t[i + 3]);
+        a = _addcarry_u64(a, t[i + 4], hi[3], &t[i + 4]);
+        carry = a;
+    }
+
+    a = _subborrow_u64(0, t[4], p[0], &r[0]);
+    a = _subborrow_u64(a, t[5], p[1], &r[1]);
+    a = _subborrow_u64(a, t[6], p[2], &r[2]);
+    a = _subborrow_u64(a, t[7], p[3], &r[3]);
+    mask = -(carry | (a ^ 1));
+    for (i = 0; i < 4; ++i) h[i] = t[i + 4] ^ (mask & (t[i + 4] ^ r[i]));
+}
+
+// s < 2^256 < 2p, so one conditional subtraction reduces it
+static void load(fe256 h, const unsigned char *s, const uint64_t *p)
+{
+    limb t[4], r[4], mask;
+    unsigned char b;
+    int i, k;
+
+    for (i = 0; i < 4; ++i) {
+        t[i] = 0;
+        for (k = 7; k >= 0; --k) t[i] = (t[i] << 8) | s[8 * i + k];
+    }
+    b = _subborrow_u64(0, t[0], p[0], &r[0]);
+    b = _subborrow_u64(b, t[1], p[1], &r[1]);
+    b = _subborrow_u64(b, t[2], p[2], &r[2]);
+    b = _subborrow_u64(b, t[3], p[3], &r[3]);
+    mask = (limb) b - 1;
+    for (i = 0; i < 4; ++i) h[i] = t[i] ^ (mask & (t[i] ^ r[i]));
+}
+
+void fe256_p256_frombytes(fe256 h, const unsigned char *s)
+{
+    load(h, s, p256);
+}
+
+void fe256_sm2_frombytes(fe256 h, const unsigned char *s)
+{
+    load(h, s, sm2);
+}
+
+void fe256_tobytes(unsigned char *s, const fe256 f)
+{
+    int i;
+
+    for (i = 0; i < 32; ++i) s[i] = f[i >> 3] >> (8 * (i & 7));
+}
+
+void fe256_p256_mul(fe256 h, const fe256 f, const fe256 g)
+{
+    uint64_t c[8];
+
+    COUNT(mul);
+    mul512(c, f, g);
+    redc(h, c, p256, p256_1);
+}
+
+void fe256_p256_sqr(fe256 h, const fe256 f)
+{
+    uint64_t c[8];
+
+    COUNT(sqr);
+    sqr512(c, f);
+    redc(h, c, p256, p256_1);
+}
+
+void fe256_p256_sqr_n(fe256 h, const fe256 f, int k)
+{
+    memmove(h, f, sizeof(fe256));
+    while (k-- > 0) fe256_p256_sqr(h, h);
+}
+
+void fe256_p256_in(fe256 h, const fe256 f)
+{
+    fe256_p256_mul(h, f, p256_rr);
+}
+
+void fe256_p256_out(fe256 h, const fe256 f)
+{
+    static const fe256 one = { 1, 0, 0, 0 };
+
+    fe256_p256_mul(h, f, one);
+}
+
+void fe256_sm2_mul(fe256 h, const fe256 f, const fe256 g)
+{
+    uint64_t c[8];
+
+    COUNT(mul);
+    mul512(c, f, g);
+    redc(h, c, sm2, sm2_1);
+}
+
+void fe256_sm2_sqr(fe256 h, const fe256 f)
+{
+    uint64_t c[8];
+
+    COUNT(sqr);
+    sqr512(c, f);
+    redc(h, c, sm2, sm2_1);
+}
+
+void fe256_sm2_sqr_n(fe256 h, const fe256 f, int k)
+{
+    memmove(h, f, sizeof(fe256));
+    while (k-- > 0) fe256_sm2_sqr(h, h);
+}
+
+void fe256_sm2_in(fe256 h, const fe256 f)
+{
+    fe256_sm2_mul(h, f, sm2_rr);
+}
+
+void fe256_sm2_out(fe256 h, const fe256 f)
+{
+    static const fe256 one = { 1, 0, 0, 0 };
+
+    fe256_sm2_mul(h, f, one);
+}
+
+// CIOS Montgomery multiplication, h = f g / 2^256 mod p.  The
+// running value stays below 2p < 2^257, so one extra word carries the
+// top bit into the final conditional subtraction.
+void fe256_mont_mul(fe256 h, const fe256 f, const fe256 g, const fe256_modulus *m)
+{
+    uint64_t t[6] = { 0, 0, 0, 0, 0, 0 };
+    uint64_t r[4];
+    uint64_t c, q, borrow, mask;
+    uint128 uv;
+    int i, j;
+
+    COUNT(mul);
+    for (i = 0; i < 4; ++i) {
+        c = 0;
+        for (j = 0; j < 4; ++j) {
+            uv = (uint128) f[j] * g[i] + t[j] + c;
+            t[j] = (uint64_t) uv;
+            c = (uint64_t) (uv >> 64);
+        }
+        uv = (uint128) t[4] + c;
+        t[4] = (uint64_t) uv;
+        t[5] = (uint64_t) (uv >> 64);
+
+        q = t[0] * m->pinv;
+        uv = (uint128) q * m->p[0] + t[0];
+        c = (uint64_t) (uv >> 64);
+        for (j = 1; j < 4; ++j) {
+            uv = (uint128) q * m->p[j] + t[j] + c;
+            t[j - 1] = (uint64_t) uv;
+            c = (uint64_t) (uv >> 64);
+        }
+        uv = (uint128) t[4] + c;
+        t[3] = (uint64_t) uv;
+        t[4] = t[5] + (uint64_t) (uv >> 64);
+    }
+
+    borrow = 0;
+    for (i = 0; i < 4; ++i) {
+        uv = (uint128) t[i] - m->p[i] - borrow;
+        r[i] = (uint64_t) uv;
+        borrow = (uint64_t) (uv >> 64) & 1;
+    }
+    mask = -(uint64_t) (t[4] >= borrow);
+    for (i = 0; i < 4; ++i) h[i] = t[i] ^ (mask & (t[i] ^ r[i]));
+}
+
+void fe256_mont_sqr(fe256 h, const fe256 f, const fe256_modulus *m)
+{
+#ifdef FE256_COUNT
+    --fe256_count_mul;
+    ++fe256_count_sqr;
+#endif
+    fe256_mont_mul(h, f, f, m);
+}
+
+void fe256_mont_sqr_n(fe256 h, const fe256 f, int k, const fe256_modulus *m)
+{
+    memmove(h, f, sizeof(fe256));
+    while (k-- > 0) fe256_mont_sqr(h, h, m);
+}
+
+void fe256_mont_in(fe256 h, const fe256 f, const fe256_modulus *m)
+{
+    fe256_mont_mul(h, f, m->rr, m);
+}
+
+void fe256_mont_out(fe256 h, const fe256 f, const fe256_modulus *m)
+{
+    static const fe256 one = { 1, 0, 0, 0 };
+
+    fe256_mont_mul(h, f, one, m);
+}
+
+// p - 2 = ffffffff 00000001 00000000 00000000 00000000 ffffffff ffffffff fffffffd
+//
+// The chain of Hu et al., with z3, z15, t0 .. t5 named as in the paper;
+// the comment on each step gives the run of exponent bits it builds.
+// 255 squarings and 12 multiplications, plus the two conversions.
+void fe256_p256_invert(fe256 h, const fe256 z)
+{
+    fe256 zm, z3, z15, t0, t1, t2, t3, t;
+
+    fe256_p256_in(zm, z);
+    // z3 = z^2 * z                          11
+    fe256_p256_sqr(z3, zm);
+    fe256_p256_mul(z3, z3, zm);
+    // z15 = z3^(2^2) * z3                   1^4
+    fe256_p256_sqr_n(z15, z3, 2);
+    fe256_p256_mul(z15, z15, z3);
+    // t0 = z15^(2^2) * z3                   1^6
+    fe256_p256_sqr_n(t0, z15, 2);
+    fe256_p256_mul(t0, t0, z3);
+    // t1 = t0^(2^6) * t0                    1^12
+    fe256_p256_sqr_n(t1, t0, 6);
+    fe256_p256_mul(t1, t1, t0);
+    // t2 = (t1^(2^12) * t1)^(2^6) * t0      1^30
+    fe256_p256_sqr_n(t2, t1, 12);
+    fe256_p256_mul(t2, t2, t1);
+    fe256_p256_sqr_n(t2, t2, 6);
+    fe256_p256_mul(t2, t2, t0);
+    // t3 = t2^(2^2) * z3                    1^32
+    fe256_p256_sqr_n(t3, t2, 2);
+    fe256_p256_mul(t3, t3, z3);
+    // t4 = (t3^(2^32) * z)^(2^96)           1^32 0^31 1 0^96
+    fe256_p256_sqr_n(t, t3, 32);
+    fe256_p256_mul(t, t, zm);
+    fe256_p256_sqr_n(t, t, 96);
+    // t5 = (t4^(2^32) * t3)^(2^32) * t3     ... 1^64
+    fe256_p256_sqr_n(t, t, 32);
+    fe256_p256_mul(t, t, t3);
+    fe256_p256_sqr_n(t, t, 32);
+    fe256_p256_mul(t, t, t3);
+    // t = (t5^(2^30) * t2)^(2^2) * z        ... 1^30 01
+    fe256_p256_sqr_n(t, t, 30);
+    fe256_p256_mul(t, t, t2);
+    fe256_p256_sqr_n(t, t, 2);
+    fe256_p256_mul(t, t, zm);
+    fe256_p256_out(h, t);
+}
+
+// p - 2 = fffffffe ffffffff ffffffff ffffffff ffffffff 00000000 ffffffff fffffffd
+//
+// The same runs of ones as for P-256 up to 1^32, plus 1^31 for the top
+// word; 256 squarings and 15 multiplications, plus the two conversions.
+void fe256_sm2_invert(fe256 h, const fe256 z)
+{
+    fe256 zm, z3, z15, t0, t1, t2, t3, t4, t5, t;
+    int i;
+
+    fe256_sm2_in(zm, z);
+    // z3 = z^2 * z                          11
+    fe256_sm2_sqr(z3, zm);
+    fe256_sm2_mul(z3, z3, zm);
+    // z15 = z3^(2^2) * z3                   1^4
+    fe256_sm2_sqr_n(z15, z3, 2);
+    fe256_sm2_mul(z15, z15, z3);
+    // t0 = z15^(2^2) * z3                   1^6
+    fe256_sm2_sqr_n(t0, z15, 2);
+    fe256_sm2_mul(t0, t0, z3);
+    // t1 = t0^(2^6) * t0                    1^12
+    fe256_sm2_sqr_n(t1, t0, 6);
+    fe256_sm2_mul(t1, t1, t0);
+    // t2 = t1^(2^12) * t1                   1^24
+    fe256_sm2_sqr_n(t2, t1, 12);
+    fe256_sm2_mul(t2, t2, t1);
+    // t3 = t2^(2^6) * t0                    1^30
+    fe256_sm2_sqr_n(t3, t2, 6);
+    fe256_sm2_mul(t3, t3, t0);
+    // t4 = t3^2 * z                         1^31
+    fe256_sm2_sqr(t4, t3);
+    fe256_sm2_mul(t4, t4, zm);
+    // t5 = t4^2 * z                         1^32
+    fe256_sm2_sqr(t5, t4);
+    fe256_sm2_mul(t5, t5, zm);
+    // t = t4^(2^33) * t5                    1^31 0 1^32
+    fe256_sm2_sqr_n(t, t4, 33);
+    fe256_sm2_mul(t, t, t5);
+    // t = (t^(2^32) * t5) three times       ... 1^128
+    for (i = 0; i < 3; ++i) {
+        fe256_sm2_sqr_n(t, t, 32);
+        fe256_sm2_mul(t, t, t5);
+    }
+    // t = t^(2^64) * t5                     ... 0^32 1^32
+    fe256_sm2_sqr_n(t, t, 64);
+    fe256_sm2_mul(t, t, t5);
+    // t = (t^(2^30) * t3)^(2^2) * z         ... 1^30 01
+    fe256_sm2_sqr_n(t, t, 30);
+    fe256_sm2_mul(t, t, t3);
+    fe256_sm2_sqr_n(t, t, 2);
+    fe256_sm2_mul(t, t, zm);
+    fe256_sm2_out(h, t);
+}
@@ -0,0 +1,69 @@
+#ifndef FE256_H
+#define FE256_H
+
+#include <stdint.h>
+
+// 4x64-bit field elements for the two primes used by the addition
+// chains:
+//
+//   P-256: p = 2^256 - 2^224 + 2^192 + 2^96 - 1
+//   SM2:   p = 2^256 - 2^224 - 2^96 + 2^64 - 1
+//
+// Both are -1 mod 2^64, which makes their Montgomery reduction nearly
+// free of the quotient multiplications, so mul, sqr and sqr_n work in
+// the Montgomery domain like fe256_mont_* below: mul(f, g) = f g / 2^256.
+// frombytes, tobytes and invert take and give standard form.
+//
+// Limbs are little-endian and every function returns a fully reduced
+// result (0 <= h < p).  Outputs may alias inputs.  Nothing allocates
+// and nothing branches on the data.
+
+typedef uint64_t fe256[4];
+
+// 32 little-endian bytes, any value below 2^256
+void fe256_p256_frombytes(fe256 h, const unsigned char *s);
+void fe256_sm2_frombytes(fe256 h, const unsigned char *s);
+void fe256_tobytes(unsigned char *s, const fe256 f);
+
+void fe256_p256_mul(fe256 h, const fe256 f, const fe256 g);
+void fe256_p256_sqr(fe256 h, const fe256 f);
+// h = f^(2^k), k >= 0
+void fe256_p256_sqr_n(fe256 h, const fe256 f, int k);
+// f < p in, f 2^256 mod p out, and back
+void fe256_p256_in(fe256 h, const fe256 f);
+void fe256_p256_out(fe256 h, const fe256 f);
+
+void fe256_sm2_mul(fe256 h, const fe256 f, const fe256 g);
+void fe256_sm2_sqr(fe256 h, const fe256 f);
+void fe256_sm2_sqr_n(fe256 h, const fe256 f, int k);
+void fe256_sm2_in(fe256 h, const fe256 f);
+void fe256_sm2_out(fe256 h, const fe256 f);
+
+// h = z^(p-2) by the addition chains in fe256.c, run in the Montgomery
+// domain; 1/0 = 0
+void fe256_p256_invert(fe256 h, const fe256 z);
+void fe256_sm2_invert(fe256 h, const fe256 z);
+
+// Any other odd modulus p < 2^256 goes through Montgomery arithmetic:
+// elements are kept as f 2^256 mod p, and mul(f, g) = f g / 2^256.
+typedef struct {
+    uint64_t p[4];
+    uint64_t pinv;  // -1/p mod 2^64
+    uint64_t rr[4]; // 2^512 mod p, to enter the Montgomery domain
+} fe256_modulus;
+
+void fe256_mont_mul(fe256 h, const fe256 f, const fe256 g, const fe256_modulus *m);
+void fe256_mont_sqr(fe256 h, const fe256 f, const fe256_modulus *m);
+void fe256_mont_sqr_n(fe256 h, const fe256 f, int k, const fe256_modulus *m);
+// f < p in, f 2^256 mod p out, and back
+void fe256_mont_in(fe256 h, const fe256 f, const fe256_modulus *m);
+void fe256_mont_out(fe256 h, const fe256 f, const fe256_modulus *m);
+
+#ifdef FE256_COUNT
+// Built with -DFE256_COUNT, every mul and sqr (including the ones inside
+// sqr_n, and the mul inside each _in/_out) bumps these, so a chain's
+// cost can be read off directly.
+extern unsigned long long fe256_count_mul, fe256_count_sqr;
+#endif
+
+#endif
@@ -1,8 +1,357 @@
 #include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <gmp.h>
+#include "fe256.h"
+#include "fermat_inverse.h"
+#include "sqrt256.h"
 
+// fe256 against gmp: random and edge-case operands for mul, sqr,
+// sqr_n and the inversion chains of both primes, then the Montgomery
+// arithmetic and the generated fermat_inverse_<name>() of every
+// modulus chaingen knows, and the generated sqrt256_<name>().  Built with -DFE256_COUNT (make count) it
+// also checks that each chain costs exactly the squarings and
+// multiplications it is documented to.
 
+typedef struct {
+    const char *name;
+    const char *hex;
+    void (*frombytes)(fe256, const unsigned char *);
+    void (*mul)(fe256, const fe256, const fe256);
+    void (*sqr)(fe256, const fe256);
+    void (*sqr_n)(fe256, const fe256, int);
+    void (*in)(fe256, const fe256);
+    void (*out)(fe256, const fe256);
+    void (*invert)(fe256, const fe256);
+    unsigned long long sqrs, muls;
+} field;
 
-int main() {
-    printf("111");
-return 0;
+static field fields[2] = {
+    { "P256", "ffffffff00000001000000000000000000000000ffffffffffffffffffffffff",
+      fe256_p256_frombytes, fe256_p256_mul, fe256_p256_sqr, fe256_p256_sqr_n,
+      fe256_p256_in, fe256_p256_out, fe256_p256_invert, 255, 14 },
+    { "SM2", "fffffffeffffffffffffffffffffffffffffffff00000000ffffffffffffffff",
+      fe256_sm2_frombytes, fe256_sm2_mul, fe256_sm2_sqr, fe256_sm2_sqr_n,
+      fe256_sm2_in, fe256_sm2_out, fe256_sm2_invert, 256, 17 },
+};
+
+typedef struct {
+    const char *name;
+    const char *hex;
+    void (*invert)(fe256, const fe256);
+    unsigned long long sqrs, muls;
+} chain;
+
+#define CHAIN(n, hex) { #n, hex, fermat_inverse_##n, fermat_inverse_##n##_sqrs, fermat_inverse_##n##_muls }
+
+static chain chains[7] = {
+    CHAIN(sm2_p, "fffffffeffffffffffffffffffffffffffffffff00000000ffffffffffffffff"),
+    CHAIN(sm2_n, "fffffffeffffffffffffffffffffffff7203df6b21c6052b53bbf40939d54123"),
+    CHAIN(P256_p, "ffffffff00000001000000000000000000000000ffffffffffffffffffffffff"),
+    CHAIN(P256_n, "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632551"),
+    CHAIN(BTC_p, "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f"),
+    CHAIN(BTC_n, "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141"),
+    CHAIN(25519, "7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffed"),
+};
+
+typedef struct {
+    const char *name;
+    const char *hex;
+    int (*sqrt)(fe256, const fe256);
+    void (*batch)(fe256 *, int *, const fe256 *, long long);
+    unsigned long long sqrs, muls;
+} root;
+
+#define ROOT(n, hex) { #n, hex, sqrt256_##n, sqrt256_##n##_batch, sqrt256_##n##_sqrs, sqrt256_##n##_muls }
+
+static root roots[4] = {
+    ROOT(sm2_p, "fffffffeffffffffffffffffffffffffffffffff00000000ffffffffffffffff"),
+    ROOT(sm2_n, "fffffffeffffffffffffffffffffffff7203df6b21c6052b53bbf40939d54123"),
+    ROOT(P256_p, "ffffffff00000001000000000000000000000000ffffffffffffffffffffffff"),
+    ROOT(BTC_p, "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f"),
+};
+
+static mpz_t p, a, b, c, d, r;
+static gmp_randstate_t state;
+
+static void import(mpz_t z, const fe256 f)
+{
+    mpz_import(z, 4, -1, 8, 0, 0, f);
+}
+
+static void check(const fe256 h, mpz_t want)
+{
+    import(d, h);
+    assert(mpz_cmp(d, want) == 0);
+}
+
+// a value near one of the edges that the carry chains have to get right
+static void operand(mpz_t z, long i)
+{
+    switch (i % 8) {
+        case 0: mpz_set_ui(z, i / 8); break;
+        case 1: mpz_sub_ui(z, p, 1 + i / 8); break;
+        case 2: mpz_set_ui(z, 0); mpz_setbit(z, 255); mpz_sub_ui(z, z, i / 8); break;
+        default: mpz_urandomm(z, state, p); break;
+    }
+    if (mpz_cmp(z, p) >= 0) mpz_mod(z, z, p);
+}
+
+static void checkfield(field *F)
+{
+    unsigned char s[32];
+    fe256 f, g, h;
+    long i;
+    int k;
+
+    printf("%s checking frombytes\n", F->name);
+    for (i = 0; i < 1000; ++i) {
+        mpz_urandomb(a, state, 256);
+        if (i < 500) {
+            mpz_set_ui(a, 0);
+            mpz_setbit(a, 256);
+            mpz_sub_ui(a, a, i + 1);
+        }
+        memset(s, 0, 32);
+        mpz_export(s, 0, -1, 1, 0, 0, a);
+        F->frombytes(f, s);
+        mpz_mod(c, a, p);
+        check(f, c);
+        fe256_tobytes(s, f);
+        mpz_import(d, 32, -1, 1, 0, 0, s);
+        assert(mpz_cmp(d, c) == 0);
+    }
+
+    // r = 1/2^256, which every Montgomery product carries
+    mpz_set_ui(r, 0);
+    mpz_setbit(r, 256);
+    mpz_invert(r, r, p);
+
+    printf("%s checking mul and sqr\n", F->name);
+    for (i = 0; i < 100000; ++i) {
+        operand(a, i);
+        operand(b, i / 8);
+        memset(f, 0, sizeof f);
+        memset(g, 0, sizeof g);
+        mpz_export(f, 0, -1, 8, 0, 0, a);
+        mpz_export(g, 0, -1, 8, 0, 0, b);
+        F->mul(h, f, g);
+        mpz_mul(c, a, b);
+        mpz_mul(c, c, r);
+        mpz_mod(c, c, p);
+        check(h, c);
+        F->sqr(h, f);
+        mpz_mul(c, a, a);
+        mpz_mul(c, c, r);
+        mpz_mod(c, c, p);
+        check(h, c);
+        F->mul(f, f, f);
+        check(f, c);
+
+        memset(f, 0, sizeof f);
+        mpz_export(f, 0, -1, 8, 0, 0, a);
+        F->in(f, f);
+        F->in(g, g);
+        F->mul(h, f, g);
+        F->out(h, h);
+        mpz_mul(c, a, b);
+        mpz_mod(c, c, p);
+        check(h, c);
+        F->out(f, f);
+        check(f, a);
+    }
+
+    printf("%s checking sqr_n\n", F->name);
+    for (k = 0; k <= 96; ++k) {
+        mpz_urandomm(a, state, p);
+        memset(f, 0, sizeof f);
+        mpz_export(f, 0, -1, 8, 0, 0, a);
+        F->in(f, f);
+        F->sqr_n(h, f, k);
+        F->out(h, h);
+        mpz_set_ui(b, 0);
+        mpz_setbit(b, k);
+        mpz_powm(c, a, b, p);
+        check(h, c);
+    }
+
+    printf("%s checking invert\n", F->name);
+    for (i = 0; i < 1000; ++i) {
+        operand(a, i);
+        memset(f, 0, sizeof f);
+        mpz_export(f, 0, -1, 8, 0, 0, a);
+        F->invert(h, f);
+        if (!mpz_invert(c, a, p)) mpz_set_ui(c, 0);
+        check(h, c);
+    }
+
+#ifdef FE256_COUNT
+    fe256_count_sqr = fe256_count_mul = 0;
+    F->invert(h, f);
+    printf("%s invert costs %lluS + %lluM\n", F->name, fe256_count_sqr, fe256_count_mul);
+    assert(fe256_count_sqr == F->sqrs);
+    assert(fe256_count_mul == F->muls);
+#endif
+}
+
+static void load(fe256 f, mpz_t z)
+{
+    memset(f, 0, sizeof(fe256));
+    mpz_export(f, 0, -1, 8, 0, 0, z);
+}
+
+// the Montgomery layer against gmp, for the modulus now in p
+static void checkmont(const char *name)
+{
+    fe256_modulus m;
+    fe256 f, g, h;
+    long i;
+    int k;
+
+    load(m.p, p);
+    mpz_set_ui(a, 0);
+    mpz_setbit(a, 64);
+    mpz_invert(a, p, a);
+    mpz_ui_sub(a, 0, a);
+    mpz_fdiv_r_2exp(a, a, 64);
+    m.pinv = mpz_get_ui(a);
+    mpz_set_ui(a, 0);
+    mpz_setbit(a, 512);
+    mpz_mod(a, a, p);
+    load(m.rr, a);
+
+    printf("%s checking mont_mul and mont_sqr\n", name);
+    for (i = 0; i < 10000; ++i) {
+        operand(a, i);
+        operand(b, i / 8);
+        load(f, a);
+        load(g, b);
+        fe256_mont_in(f, f, &m);
+        fe256_mont_in(g, g, &m);
+        fe256_mont_mul(h, f, g, &m);
+        fe256_mont_out(h, h, &m);
+        mpz_mul(c, a, b);
+        mpz_mod(c, c, p);
+        check(h, c);
+        fe256_mont_sqr(h, f, &m);
+        fe256_mont_out(h, h, &m);
+        mpz_mul(c, a, a);
+        mpz_mod(c, c, p);
+        check(h, c);
+        fe256_mont_out(f, f, &m);
+        check(f, a);
+    }
+
+    for (k = 0; k <= 96; ++k) {
+        mpz_urandomm(a, state, p);
+        load(f, a);
+        fe256_mont_in(f, f, &m);
+        fe256_mont_sqr_n(h, f, k, &m);
+        fe256_mont_out(h, h, &m);
+        mpz_set_ui(b, 0);
+        mpz_setbit(b, k);
+        mpz_powm(c, a, b, p);
+        check(h, c);
+    }
+}
+
+static void checkchain(chain *C)
+{
+    fe256 f, h;
+    long i;
+
+    checkmont(C->name);
+
+    printf("%s checking fermat_inverse\n", C->name);
+    for (i = 0; i < 1000; ++i) {
+        operand(a, i);
+        load(f, a);
+        C->invert(h, f);
+        if (!mpz_invert(c, a, p)) mpz_set_ui(c, 0);
+        check(h, c);
+    }
+
+#ifdef FE256_COUNT
+    fe256_count_sqr = fe256_count_mul = 0;
+    C->invert(h, f);
+    printf("%s fermat_inverse costs %lluS + %lluM\n", C->name, fe256_count_sqr, fe256_count_mul);
+    assert(fe256_count_sqr == C->sqrs);
+    assert(fe256_count_mul == C->muls);
+#endif
+}
+
+// found exactly for the squares (0 included), h^2 = z then and -z
+// otherwise; in place and batched the same
+static void checkroot(root *R)
+{
+    fe256 f, g, h, z[64], r[64];
+    int found, flags[64];
+    long i;
+
+    printf("%s checking sqrt256\n", R->name);
+    for (i = 0; i < 2000; ++i) {
+        operand(a, i);
+        if (i % 8 == 7) mpz_mul(a, a, a);
+        mpz_mod(a, a, p);
+        load(f, a);
+        found = R->sqrt(h, f);
+        assert(found == (mpz_legendre(a, p) >= 0));
+        import(b, h);
+        assert(mpz_cmp(b, p) < 0);
+        mpz_mul(c, b, b);
+        if (!found) mpz_neg(c, c);
+        mpz_sub(c, c, a);
+        assert(mpz_divisible_p(c, p));
+        memcpy(g, f, sizeof g);
+        assert(R->sqrt(g, g) == found);
+        assert(memcmp(g, h, sizeof h) == 0);
+    }
+
+    for (i = 0; i < 64; ++i) {
+        operand(a, i);
+        load(z[i], a);
+    }
+    R->batch(r, flags, (const fe256 *) z, 64);
+    for (i = 0; i < 64; ++i) {
+        found = R->sqrt(h, z[i]);
+        assert(flags[i] == found);
+        assert(memcmp(r[i], h, sizeof h) == 0);
+    }
+    R->batch(z, flags, (const fe256 *) z, 64);
+    assert(memcmp(z, r, sizeof r) == 0);
+
+#ifdef FE256_COUNT
+    fe256_count_sqr = fe256_count_mul = 0;
+    R->sqrt(h, f);
+    printf("%s sqrt256 costs %lluS + %lluM\n", R->name, fe256_count_sqr, fe256_count_mul);
+    assert(fe256_count_sqr == R->sqrs);
+    assert(fe256_count_mul == R->muls);
+#endif
+}
+
+int main(void)
+{
+    int k;
+
+    mpz_inits(p, a, b, c, d, r, NULL);
+    gmp_randinit_default(state);
+
+    for (k = 0; k < 2; ++k) {
+        mpz_set_str(p, fields[k].hex, 16);
+        checkfield(&fields[k]);
+    }
+
+    for (k = 0; k < 7; ++k) {
+        mpz_set_str(p, chains[k].hex, 16);
+        checkchain(&chains[k]);
+    }
+
+    for (k = 0; k < 4; ++k) {
+        mpz_set_str(p, roots[k].hex, 16);
+        checkroot(&roots[k]);
+    }
+
+    mpz_clears(p, a, b, c, d, r, NULL);
+    gmp_randclear(state);
+    return 0;
 }
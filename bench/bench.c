@@ -0,0 +1,306 @@
+#include <gmp.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <time.h>
+#include "inverse256.h"
+#include "measure.h"
+#include "fe256.h"
+#include "fermat_inverse.h"
+#include "inverse25519.h"
+
+/* One benchmark for every inversion backend in the tree, on every
+   modulus it supports, all timed by the same harness (measure.c):
+
+     safegcd        inverse256_<m>() (asm or portable, see cpu.c);
+                    inverse256_generic() for moduli without a table
+     safegcd-port   inverse256_portable(), forced
+     safegcd-x4     inverse256_<m>_x4(), cycles per element
+     safegcd-batch  inverse256_<m>_batch() on 64 elements, per element
+     dedicated      a modulus's own asm: inverse25519() from
+                    inverse25519skylake (AVX2 only)
+     fermat         generated fermat_inverse_<m>() (addChain_File)
+     fermat-hand    the paper's chains, fe256_{p256,sm2}_invert()
+     gmp            mpz_invert()
+
+   Each sample is one call, less the cost of an empty sample; the
+   report is cycles per inversion (median with its 95% confidence
+   interval, min, p90, p99), instructions and branch misses per
+   inversion when perf_event is available, and ns per inversion from
+   the wall clock over the whole run, warm-up included.
+
+     ./bench [-n samples] [-w warmup] [-p cpu] [-j file.json] [-c file.csv]
+*/
+
+typedef struct {
+  const char *name;
+  const char *hex;
+  void (*safegcd)(unsigned char *,const unsigned char *);
+  void (*x4)(unsigned char (*)[32],const unsigned char (*)[32]);
+  void (*batch)(unsigned char *,const unsigned char *,long long);
+  void (*dedicated)(unsigned char *,const unsigned char *);
+  void (*fermat)(fe256,const fe256);
+  void (*hand)(fe256,const fe256);
+} modulus;
+
+static modulus moduli[] = {
+  { "sm2_p", "fffffffeffffffffffffffffffffffffffffffff00000000ffffffffffffffff",
+    inverse256_sm2_p, inverse256_sm2_p_x4, inverse256_sm2_p_batch, 0, fermat_inverse_sm2_p, fe256_sm2_invert },
+  { "sm2_n", "fffffffeffffffffffffffffffffffff7203df6b21c6052b53bbf40939d54123",
+    0, 0, 0, 0, fermat_inverse_sm2_n, 0 },
+  { "P256_p", "ffffffff00000001000000000000000000000000ffffffffffffffffffffffff",
+    inverse256_P256_p, inverse256_P256_p_x4, inverse256_P256_p_batch, 0, fermat_inverse_P256_p, fe256_p256_invert },
+  { "P256_n", "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632551",
+    inverse256_P256_n, inverse256_P256_n_x4, inverse256_P256_n_batch, 0, fermat_inverse_P256_n, 0 },
+  { "BTC_p", "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f",
+    inverse256_BTC_p, inverse256_BTC_p_x4, inverse256_BTC_p_batch, 0, fermat_inverse_BTC_p, 0 },
+  { "BTC_n", "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141",
+    inverse256_BTC_n, inverse256_BTC_n_x4, inverse256_BTC_n_batch, 0, fermat_inverse_BTC_n, 0 },
+  { "25519", "7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffed",
+    0, 0, 0, inverse25519, fermat_inverse_25519, 0 },
+} ;
+
+#define NMODULI (sizeof moduli / sizeof moduli[0])
+
+enum { SAFEGCD, PORTABLE, X4, BATCH, DEDICATED, FERMAT, HAND, GMP, NBACKENDS };
+
+static const char *backends[NBACKENDS] = {
+  "safegcd", "safegcd-port", "safegcd-x4", "safegcd-batch", "dedicated", "fermat", "fermat-hand", "gmp"
+} ;
+
+/* 64 inputs below p in each representation; call k uses input k%64 */
+#define INPUTS 64
+
+static unsigned char in[INPUTS][32];
+static unsigned char out[INPUTS][32];
+static fe256 fin[INPUTS];
+static fe256 fout;
+static mpz_t zin[INPUTS];
+static mpz_t zout;
+static mpz_t p_gmp;
+static unsigned char p[32];
+static const int64_t *table;
+static const modulus *m;
+static long long j;
+
+static int available(int b)
+{
+  switch (b) {
+    case X4: return m->x4 != 0;
+    case BATCH: return m->batch != 0;
+    case DEDICATED: return m->dedicated != 0 && !strcmp(inverse256_implementation(),"avx2");
+    case HAND: return m->hand != 0;
+  }
+  return 1;
+}
+
+static void safegcd(void *arg)
+{
+  j = (j+1)%INPUTS;
+  if (m->safegcd) m->safegcd(out[0],in[j]);
+  else inverse256_generic(out[0],in[j],p);
+}
+
+static void portable(void *arg)
+{
+  j = (j+1)%INPUTS;
+  inverse256_portable(out[0],in[j],table);
+}
+
+static void x4(void *arg)
+{
+  j = (j+4)%INPUTS;
+  m->x4(out,(const unsigned char (*)[32]) in+j);
+}
+
+static void batch(void *arg)
+{
+  m->batch(out[0],in[0],INPUTS);
+}
+
+static void dedicated(void *arg)
+{
+  j = (j+1)%INPUTS;
+  m->dedicated(out[0],in[j]);
+}
+
+static void fermat(void *arg)
+{
+  j = (j+1)%INPUTS;
+  m->fermat(fout,fin[j]);
+}
+
+static void hand(void *arg)
+{
+  j = (j+1)%INPUTS;
+  m->hand(fout,fin[j]);
+}
+
+static void gmp(void *arg)
+{
+  j = (j+1)%INPUTS;
+  mpz_invert(zout,zin[j],p_gmp);
+}
+
+static void (*runners[NBACKENDS])(void *) = {
+  safegcd, portable, x4, batch, dedicated, fermat, hand, gmp
+} ;
+
+typedef struct {
+  const char *backend;
+  const char *modulus;
+  measure_result r;
+  double ns;
+} result;
+
+static result results[NMODULI*NBACKENDS];
+static long long nresults;
+
+static void run(int b,const measure_config *cfg)
+{
+  result *r = &results[nresults++];
+  struct timespec w0,w1;
+  long long ops = b == X4 ? 4 : b == BATCH ? INPUTS : 1;
+
+  clock_gettime(CLOCK_MONOTONIC,&w0);
+  measure(&r->r,runners[b],0,ops);
+  clock_gettime(CLOCK_MONOTONIC,&w1);
+
+  r->backend = backends[b];
+  r->modulus = m->name;
+  r->ns = ((w1.tv_sec-w0.tv_sec)*1e9+(w1.tv_nsec-w0.tv_nsec))/((cfg->warmup+cfg->samples)*(double) ops);
+
+  printf("%-14s %-7s %9.0f %9.0f %9.0f %9.0f %9.0f %9.0f %10.1f",
+    r->backend,r->modulus,r->r.median,r->r.lo,r->r.hi,r->r.min,r->r.p90,r->r.p99,r->ns);
+  if (r->r.instructions >= 0) printf(" %8.0f",r->r.instructions);
+  if (r->r.branchmisses >= 0) printf(" %7.2f",r->r.branchmisses);
+  printf("\n");
+  fflush(stdout);
+}
+
+static void load(gmp_randstate_t rand)
+{
+  long long i;
+
+  mpz_set_str(p_gmp,m->hex,16);
+  memset(p,0,32);
+  mpz_export(p,0,-1,1,0,0,p_gmp);
+  for (i = 0;i < INPUTS;++i) {
+    mpz_urandomm(zin[i],rand,p_gmp);
+    memset(in[i],0,32);
+    mpz_export(in[i],0,-1,1,0,0,zin[i]);
+    memset(fin[i],0,sizeof fin[i]);
+    mpz_export(fin[i],0,-1,8,0,0,zin[i]);
+  }
+  table = inverse256_table_cached(p);
+}
+
+static void cpuname(char *s,long long len)
+{
+  FILE *f = fopen("/proc/cpuinfo","r");
+  char line[256];
+  char *v;
+
+  snprintf(s,len,"unknown");
+  if (!f) return;
+  while (fgets(line,sizeof line,f))
+    if (strncmp(line,"model name",10) == 0 && (v = strchr(line,':'))) {
+      v += 1 + (v[1] == ' ');
+      v[strcspn(v,"\n\"\\")] = 0;
+      snprintf(s,len,"%s",v);
+      break;
+    }
+  fclose(f);
+}
+
+/* instructions and branch misses are -1 without perf_event */
+
+static int writejson(const char *fn,const char *cpu,const measure_config *cfg)
+{
+  FILE *f = fopen(fn,"w");
+  measure_result *r;
+  long long i;
+
+  if (!f) return -1;
+  fprintf(f,"{\n  \"cpu\": \"%s\",\n  \"engine\": \"%s\",\n  \"samples\": %lld,\n  \"warmup\": %lld,\n  \"overhead\": %lld,\n  \"results\": [\n",
+    cpu,inverse256_implementation(),cfg->samples,cfg->warmup,measure_overhead());
+  for (i = 0;i < nresults;++i) {
+    r = &results[i].r;
+    fprintf(f,"    { \"backend\": \"%s\", \"modulus\": \"%s\", \"min\": %.0f, \"median\": %.0f, \"ci_lo\": %.0f, \"ci_hi\": %.0f, \"p90\": %.0f, \"p99\": %.0f, \"mean\": %.0f, \"ns_per_op\": %.1f, \"instructions\": %.0f, \"branch_misses\": %.2f }%s\n",
+      results[i].backend,results[i].modulus,r->min,r->median,r->lo,r->hi,r->p90,r->p99,r->mean,results[i].ns,r->instructions,r->branchmisses,
+      i+1 < nresults ? "," : "");
+  }
+  fprintf(f,"  ]\n}\n");
+  return fclose(f);
+}
+
+static int writecsv(const char *fn,const char *cpu,const measure_config *cfg)
+{
+  FILE *f = fopen(fn,"w");
+  measure_result *r;
+  long long i;
+
+  if (!f) return -1;
+  fprintf(f,"cpu,engine,samples,warmup,backend,modulus,min,median,ci_lo,ci_hi,p90,p99,mean,ns_per_op,instructions,branch_misses\n");
+  for (i = 0;i < nresults;++i) {
+    r = &results[i].r;
+    fprintf(f,"\"%s\",%s,%lld,%lld,%s,%s,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.1f,%.0f,%.2f\n",
+      cpu,inverse256_implementation(),cfg->samples,cfg->warmup,
+      results[i].backend,results[i].modulus,r->min,r->median,r->lo,r->hi,r->p90,r->p99,r->mean,results[i].ns,r->instructions,r->branchmisses);
+  }
+  return fclose(f);
+}
+
+int main(int argc,char **argv)
+{
+  measure_config cfg = { 16, 1000, -1 };
+  gmp_randstate_t rand;
+  const char *json = 0;
+  const char *csv = 0;
+  long long i;
+  char cpu[256];
+  int opt,b;
+
+  while ((opt = getopt(argc,argv,"n:w:p:j:c:")) != -1)
+    switch (opt) {
+      case 'n': cfg.samples = atoll(optarg); break;
+      case 'w': cfg.warmup = atoll(optarg); break;
+      case 'p': cfg.cpu = atoi(optarg); break;
+      case 'j': json = optarg; break;
+      case 'c': csv = optarg; break;
+      default:
+        fprintf(stderr,"usage: bench [-n samples] [-w warmup] [-p cpu] [-j file.json] [-c file.csv]\n");
+        return 100;
+    }
+  if (cfg.samples < 1) cfg.samples = 1;
+  if (cfg.warmup < 0) cfg.warmup = 0;
+  if (measure_init(&cfg) != 0) return 111;
+
+  mpz_inits(p_gmp,zout,NULL);
+  for (i = 0;i < INPUTS;++i) mpz_init(zin[i]);
+  gmp_randinit_default(rand);
+
+  cpuname(cpu,sizeof cpu);
+  printf("cpu %s engine %s samples %lld warmup %lld overhead %lld cycles\n",
+    cpu,inverse256_implementation(),cfg.samples,cfg.warmup,measure_overhead());
+  printf("%-14s %-7s %9s %9s %9s %9s %9s %9s %10s %8s %7s\n",
+    "backend","modulus","median","ci_lo","ci_hi","min","p90","p99","ns/op","insns","brmiss");
+
+  for (i = 0;i < NMODULI;++i) {
+    m = &moduli[i];
+    load(rand);
+    for (b = 0;b < NBACKENDS;++b)
+      if (available(b))
+        run(b,&cfg);
+  }
+
+  if (json && writejson(json,cpu,&cfg) != 0) { perror(json); return 111; }
+  if (csv && writecsv(csv,cpu,&cfg) != 0) { perror(csv); return 111; }
+
+  for (i = 0;i < INPUTS;++i) mpz_clear(zin[i]);
+  mpz_clears(p_gmp,zout,NULL);
+  gmp_randclear(rand);
+  return 0;
+}
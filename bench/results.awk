@@ -0,0 +1,20 @@
+# the median cycles of a "bench -c" CSV as a markdown table, a row per
+# backend and a column per modulus, in the order bench runs them; this
+# is the results table of the README
+
+BEGIN { FS = "," }
+NR > 1 {
+  if (!($5 in isb)) { isb[$5] = 1; b[++nb] = $5 }
+  if (!($6 in ism)) { ism[$6] = 1; m[++nm] = $6 }
+  c[$5,$6] = $8
+}
+END {
+  s = "| |"; t = "|---|"
+  for (j = 1;j <= nm;++j) { s = s " " m[j] " |"; t = t "---:|" }
+  print s; print t
+  for (i = 1;i <= nb;++i) {
+    s = "| " b[i] " |"
+    for (j = 1;j <= nm;++j) s = s " " ((b[i],m[j]) in c ? c[b[i],m[j]] : "") " |"
+    print s
+  }
+}
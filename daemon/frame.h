@@ -0,0 +1,45 @@
+#ifndef frame_h
+#define frame_h
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* The wire format of invd: requests and responses are both FRAME
+   bytes, any number of them back to back on a Unix stream socket.
+
+     0..3   id, chosen by the client, echoed in the response
+     4      request: the function, below
+            response: 0 done, 1 unknown function (result zero)
+     5..7   zero
+     8..39  the element, 32 bytes little-endian, any value below
+            2^256; in the response its inverse, fully reduced, or 0
+            for 0 mod p
+
+   Responses on a connection come back in the order of its requests. */
+
+#define FRAME 40
+
+#define INVD_SM2_P 0
+#define INVD_P256_P 1
+#define INVD_P256_N 2
+#define INVD_BTC_P 3
+#define INVD_BTC_N 4
+#define INVD_25519 5
+#define INVD_FUNCTIONS 6
+
+/* the default socket, INVD_SOCKET in $XDG_RUNTIME_DIR, a directory
+   that only its user can enter; 0 if that is unset or too long */
+
+#define INVD_SOCKET "invd.sock"
+
+static inline const char *invd_socket(void)
+{
+  static char path[108];
+  const char *dir = getenv("XDG_RUNTIME_DIR");
+
+  if (!dir || !*dir) return 0;
+  if (snprintf(path,sizeof path,"%s/%s",dir,INVD_SOCKET) >= (int) sizeof path) return 0;
+  return path;
+}
+
+#endif
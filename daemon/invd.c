@@ -0,0 +1,351 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "inverse256.h"
+#include "inverse25519.h"
+#include "frame.h"
+
+/* invd: one copy of the inversion engines for every process of a user
+   on the host, over a Unix stream socket in the fixed frames of
+   frame.h.  The socket is $XDG_RUNTIME_DIR/invd.sock unless -s names
+   another, and is created mode 0600, so only the user that runs invd
+   can connect.  An old socket at the path is replaced only if it is a
+   socket owned by that user; anything else there is an error.
+
+     invd [-s path] [-b batch] [-w microseconds]
+
+   One thread polls all connections.  Each round it reads every
+   complete frame that has arrived, from every connection, and only
+   then inverts: the requests of one function that arrived together go
+   through Montgomery's trick in inverse256_batch(), up to batch (256)
+   at a time, and a request that is alone takes the single call,
+   inverse256_<curve>() or inverse25519().  The curves' batches run on
+   the static tables from inverse256_table_builtin(); 2^255-19 has none,
+   so its table is built once at start with inverse256_table_init(), and
+   gives the same results as inverse25519().  Requests that arrive while a batch is
+   being inverted make up the next one, so the batches grow with the
+   load by themselves; -w holds the first request of a round up to
+   that many microseconds, unless batch requests come in first, for
+   bigger batches at light load.
+
+   A connection has at most QUEUE frames read and not yet written
+   back; past that it is not read until it takes its responses, so a
+   slow client holds up only itself.  Responses go back in the order
+   of the requests.  SIGINT and SIGTERM remove the socket and print
+   the number of requests and the mean batch; responses do not carry
+   the size of their batch, which would tell a client about the
+   requests of the others. */
+
+#define CLIENTS 256
+#define QUEUE 256
+#define MAXBATCH 4096
+
+typedef struct {
+  int fd;
+  unsigned int gen;
+  long long inflight;
+  long long inlen,outlen;
+  unsigned char in[FRAME*QUEUE];
+  unsigned char out[FRAME*QUEUE];
+} client;
+
+typedef struct {
+  int client;
+  unsigned int gen;
+  unsigned char frame[FRAME];
+} request;
+
+static const unsigned char p25519[32] = {
+  0xed,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+  0xff,0xff,0xff,0xff,0xff,0xff,0xff,0x7f,
+} ;
+
+static struct {
+  const unsigned char *modulus;
+  void (*single)(unsigned char *,const unsigned char *);
+  const int64_t *table;
+} functions[INVD_FUNCTIONS] = {
+  { inverse256_sm2_p_modulus, inverse256_sm2_p },
+  { inverse256_P256_p_modulus, inverse256_P256_p },
+  { inverse256_P256_n_modulus, inverse256_P256_n },
+  { inverse256_BTC_p_modulus, inverse256_BTC_p },
+  { inverse256_BTC_n_modulus, inverse256_BTC_n },
+  { p25519, inverse25519 },
+} ;
+
+static int64_t table25519[64] __attribute__((aligned(32)));
+
+static client clients[CLIENTS];
+static request pending[CLIENTS*QUEUE];
+static long long npending,oldest;
+static long long batch = 256,wait;
+static long long served,batches;
+static volatile sig_atomic_t stop;
+
+static long long now(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC,&t);
+  return t.tv_sec*1000000000LL+t.tv_nsec;
+}
+
+static void drop(client *c)
+{
+  close(c->fd);
+  c->fd = -1;
+  ++c->gen;
+  c->inflight = 0;
+  c->inlen = 0;
+  c->outlen = 0;
+}
+
+static void readin(client *c,long long i)
+{
+  long long room = QUEUE-c->inflight-(c->outlen+FRAME-1)/FRAME;
+  long long r,k,frames;
+
+  if (room*FRAME-c->inlen <= 0) return;
+  r = read(c->fd,c->in+c->inlen,room*FRAME-c->inlen);
+  if (r < 0 && (errno == EAGAIN || errno == EINTR)) return;
+  if (r <= 0) {
+    drop(c);
+    return;
+  }
+  c->inlen += r;
+  frames = c->inlen/FRAME;
+  if (frames && !npending) oldest = now();
+  for (k = 0;k < frames;++k) {
+    pending[npending].client = i;
+    pending[npending].gen = c->gen;
+    memcpy(pending[npending].frame,c->in+FRAME*k,FRAME);
+    ++npending;
+  }
+  c->inflight += frames;
+  c->inlen -= FRAME*frames;
+  memmove(c->in,c->in+FRAME*frames,c->inlen);
+}
+
+static void writeout(client *c)
+{
+  long long w;
+
+  if (c->fd < 0 || !c->outlen) return;
+  w = write(c->fd,c->out,c->outlen);
+  if (w < 0) {
+    if (errno != EAGAIN && errno != EINTR) drop(c);
+    return;
+  }
+  c->outlen -= w;
+  memmove(c->out,c->out+w,c->outlen);
+}
+
+static void invert(long long f,unsigned char *out,const unsigned char *in,long long n)
+{
+  if (n == 1 && functions[f].single) functions[f].single(out,in);
+  else inverse256_batch(out,in,n,functions[f].table);
+}
+
+/* every pending request, in batches per function, then the responses
+   in request order; byte 7 marks the frames already answered */
+
+static void serve(void)
+{
+  static unsigned char in[32*MAXBATCH],out[32*MAXBATCH];
+  static long long index[MAXBATCH];
+  unsigned char *frame;
+  long long f,i,j,n;
+  client *c;
+
+  for (i = 0;i < npending;++i) {
+    frame = pending[i].frame;
+    frame[7] = 0;
+    if (frame[4] >= INVD_FUNCTIONS) {
+      frame[4] = 1;
+      memset(frame+5,0,FRAME-5);
+      frame[7] = 1;
+    }
+  }
+  for (f = 0;f < INVD_FUNCTIONS;++f) {
+    n = 0;
+    for (i = 0;i <= npending;++i) {
+      if (i < npending && pending[i].frame[4] == f && !pending[i].frame[7]) {
+        index[n] = i;
+        memcpy(in+32*n,pending[i].frame+8,32);
+        ++n;
+      }
+      if (n == batch || (i == npending && n)) {
+        invert(f,out,in,n);
+        for (j = 0;j < n;++j) {
+          frame = pending[index[j]].frame;
+          memcpy(frame+8,out+32*j,32);
+          frame[4] = 0;
+          frame[7] = 1;
+        }
+        served += n;
+        ++batches;
+        n = 0;
+      }
+    }
+  }
+
+  for (i = 0;i < npending;++i) {
+    c = &clients[pending[i].client];
+    if (c->fd < 0 || c->gen != pending[i].gen) continue;
+    pending[i].frame[7] = 0;
+    memcpy(c->out+c->outlen,pending[i].frame,FRAME);
+    c->outlen += FRAME;
+    --c->inflight;
+  }
+  npending = 0;
+}
+
+static void finish(int sig)
+{
+  stop = 1;
+}
+
+static void usage(void)
+{
+  fprintf(stderr,"usage: invd [-s path] [-b batch] [-w microseconds]\n");
+  exit(100);
+}
+
+int main(int argc,char **argv)
+{
+  static struct pollfd fds[CLIENTS+1];
+  static long long slot[CLIENTS+1];
+  const char *path = invd_socket();
+  struct sockaddr_un sa;
+  struct stat st;
+  mode_t mask;
+  struct sigaction act;
+  struct timespec ts,*timeout;
+  long long i,n,left;
+  int opt,fd,listener;
+
+  while ((opt = getopt(argc,argv,"s:b:w:")) != -1)
+    switch (opt) {
+      case 's': path = optarg; break;
+      case 'b': batch = atoll(optarg); break;
+      case 'w': wait = 1000*atoll(optarg); break;
+      default: usage();
+    }
+  if (batch < 1 || batch > MAXBATCH || wait < 0) usage();
+  if (!path) {
+    fprintf(stderr,"invd: no XDG_RUNTIME_DIR for the socket, use -s\n");
+    return 100;
+  }
+  if (strlen(path) >= sizeof sa.sun_path) {
+    fprintf(stderr,"invd: %s: socket path too long\n",path);
+    return 100;
+  }
+
+  for (i = 0;i < INVD_25519;++i)
+    functions[i].table = inverse256_table_builtin(functions[i].modulus);
+  if (inverse256_table_init(table25519,p25519) != 0) {
+    fprintf(stderr,"invd: no table for 2^255-19\n");
+    return 111;
+  }
+  functions[INVD_25519].table = table25519;
+  /* inverse25519() is AVX2 only; without it everything goes through
+     the dispatching engine */
+  if (strcmp(inverse256_implementation(),"avx2")) functions[INVD_25519].single = 0;
+
+  memset(&act,0,sizeof act);
+  act.sa_handler = finish;
+  sigaction(SIGINT,&act,0);
+  sigaction(SIGTERM,&act,0);
+  signal(SIGPIPE,SIG_IGN);
+
+  listener = socket(AF_UNIX,SOCK_STREAM|SOCK_NONBLOCK|SOCK_CLOEXEC,0);
+  if (listener < 0) { perror("invd: socket"); return 111; }
+  memset(&sa,0,sizeof sa);
+  sa.sun_family = AF_UNIX;
+  strcpy(sa.sun_path,path);
+  if (lstat(path,&st) == 0) {
+    if (!S_ISSOCK(st.st_mode) || st.st_uid != getuid()) {
+      fprintf(stderr,"invd: %s: exists and is not our socket\n",path);
+      return 111;
+    }
+    unlink(path);
+  } else if (errno != ENOENT) {
+    fprintf(stderr,"invd: %s: %s\n",path,strerror(errno));
+    return 111;
+  }
+  mask = umask(0177);
+  if (bind(listener,(struct sockaddr *) &sa,sizeof sa) < 0 || listen(listener,128) < 0) {
+    fprintf(stderr,"invd: %s: %s\n",path,strerror(errno));
+    return 111;
+  }
+  umask(mask);
+  for (i = 0;i < CLIENTS;++i) clients[i].fd = -1;
+  fprintf(stderr,"invd: listening on %s, %s engine, batches up to %lld\n",path,inverse256_implementation(),batch);
+
+  while (!stop) {
+    n = 0;
+    for (i = 0;i < CLIENTS;++i) {
+      client *c = &clients[i];
+      if (c->fd < 0) continue;
+      fds[n].fd = c->fd;
+      fds[n].events = 0;
+      if (QUEUE-c->inflight-(c->outlen+FRAME-1)/FRAME > 0) fds[n].events |= POLLIN;
+      if (c->outlen) fds[n].events |= POLLOUT;
+      slot[n++] = i;
+    }
+    fds[n].fd = listener;
+    fds[n].events = POLLIN;
+    slot[n++] = -1;
+
+    timeout = 0;
+    if (npending) {
+      left = oldest+wait-now();
+      if (left < 0) left = 0;
+      ts.tv_sec = left/1000000000;
+      ts.tv_nsec = left%1000000000;
+      timeout = &ts;
+    }
+    if (ppoll(fds,n,timeout,0) < 0) {
+      if (errno == EINTR) continue;
+      perror("invd: poll");
+      return 111;
+    }
+
+    for (i = 0;i < n;++i) {
+      if (!fds[i].revents) continue;
+      if (slot[i] < 0) {
+        while ((fd = accept4(listener,0,0,SOCK_NONBLOCK|SOCK_CLOEXEC)) >= 0) {
+          long long k;
+          for (k = 0;k < CLIENTS;++k) if (clients[k].fd < 0) break;
+          if (k == CLIENTS) { close(fd); continue; }
+          clients[k].fd = fd;
+        }
+        continue;
+      }
+      if (fds[i].revents&POLLOUT) writeout(&clients[slot[i]]);
+      if (clients[slot[i]].fd >= 0 && fds[i].revents&(POLLIN|POLLHUP|POLLERR))
+        readin(&clients[slot[i]],slot[i]);
+    }
+
+    if (npending && (npending >= batch || now() >= oldest+wait)) {
+      serve();
+      for (i = 0;i < CLIENTS;++i) writeout(&clients[i]);
+    }
+  }
+
+  unlink(path);
+  fprintf(stderr,"invd: %lld requests in %lld batches, %.1f per batch\n",served,batches,batches ? (double) served/batches : 0.0);
+  return 0;
+}
@@ -0,0 +1,249 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <stdint.h>
+#include <gmp.h>
+#include "frame.h"
+
+/* invload: load for invd.
+
+     invload [-s path] [-c connections] [-d depth] [-n requests] [-f function] [-v]
+
+   Each of the connections (4) is a thread that keeps depth (16)
+   requests in flight and sends requests (100000) in all, random
+   elements for one function (sm2_p, P256_p, P256_n, BTC_p, BTC_n,
+   25519, or all of them in turn).  Latency runs from the write of a
+   request to the read of its response.  Prints the throughput and the
+   latency percentiles; with -v every result is checked with gmp.  Exits 1 on any
+   wrong or missing response.  The socket is invd's default,
+   $XDG_RUNTIME_DIR/invd.sock, unless -s names another. */
+
+#define MAXDEPTH 256
+
+static const struct {
+  const char *name;
+  const char *hex;
+} functions[INVD_FUNCTIONS] = {
+  { "sm2_p", "fffffffeffffffffffffffffffffffffffffffff00000000ffffffffffffffff" },
+  { "P256_p", "ffffffff00000001000000000000000000000000ffffffffffffffffffffffff" },
+  { "P256_n", "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632551" },
+  { "BTC_p", "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f" },
+  { "BTC_n", "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141" },
+  { "25519", "7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffed" },
+} ;
+
+typedef struct {
+  pthread_t id;
+  long long seed;
+  long long *latency;
+  long long errors;
+} conn;
+
+static const char *path;
+static long long depth = 16,requests = 100000,function = 0,verify;
+static mpz_t moduli[INVD_FUNCTIONS];
+
+static long long now(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC,&t);
+  return t.tv_sec*1000000000LL+t.tv_nsec;
+}
+
+static uint64_t xorshift(uint64_t *s)
+{
+  *s ^= *s<<13;
+  *s ^= *s>>7;
+  *s ^= *s<<17;
+  return *s;
+}
+
+static int writeall(int fd,const unsigned char *s,long long len)
+{
+  long long w;
+
+  while (len > 0) {
+    w = write(fd,s,len);
+    if (w < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    s += w;
+    len -= w;
+  }
+  return 0;
+}
+
+/* request i of a connection, into frame */
+
+static void request(unsigned char *frame,long long i,uint64_t *s)
+{
+  uint64_t x;
+  long long j,k;
+
+  memset(frame,0,FRAME);
+  for (j = 0;j < 4;++j) frame[j] = i>>(8*j);
+  frame[4] = function < 0 ? i%INVD_FUNCTIONS : function;
+  for (j = 0;j < 4;++j) {
+    x = xorshift(s);
+    for (k = 0;k < 8;++k) frame[8+8*j+k] = x>>(8*k);
+  }
+  if (i%97 == 13) memset(frame+8,0,32);
+}
+
+static int check(const unsigned char *response,const unsigned char *sent,mpz_t x,mpz_t y)
+{
+  long long f = sent[4];
+
+  if (memcmp(response,sent,4) || response[4] || response[5] || response[6] || response[7]) return 0;
+  if (!verify) return 1;
+  mpz_import(x,32,-1,1,0,0,sent+8);
+  mpz_import(y,32,-1,1,0,0,response+8);
+  if (mpz_cmp(y,moduli[f]) >= 0) return 0;
+  mpz_mul(y,x,y);
+  mpz_mod(y,y,moduli[f]);
+  if (mpz_cmp_ui(y,1) == 0) return 1;
+  mpz_mod(x,x,moduli[f]);
+  mpz_import(y,32,-1,1,0,0,response+8);
+  return !mpz_sgn(x) && !mpz_sgn(y);
+}
+
+static void *run(void *arg)
+{
+  conn *k = arg;
+  static __thread unsigned char in[FRAME*MAXDEPTH],out[FRAME*MAXDEPTH],sent[FRAME*MAXDEPTH];
+  static __thread long long when[MAXDEPTH];
+  uint64_t s = 0x9e3779b97f4a7c15ULL*(k->seed+1);
+  struct sockaddr_un sa;
+  long long next = 0,done = 0,have = 0,r,m,j,t;
+  unsigned char *frame;
+  mpz_t x,y;
+  int fd;
+
+  mpz_inits(x,y,NULL);
+  fd = socket(AF_UNIX,SOCK_STREAM,0);
+  memset(&sa,0,sizeof sa);
+  sa.sun_family = AF_UNIX;
+  strncpy(sa.sun_path,path,sizeof sa.sun_path-1);
+  if (fd < 0 || connect(fd,(struct sockaddr *) &sa,sizeof sa) < 0) {
+    fprintf(stderr,"invload: %s: %s\n",path,strerror(errno));
+    exit(111);
+  }
+
+  for (;next < depth && next < requests;++next) {
+    frame = sent+FRAME*(next%depth);
+    request(frame,next,&s);
+    memcpy(out+FRAME*next,frame,FRAME);
+    when[next%depth] = now();
+  }
+  if (writeall(fd,out,FRAME*next) < 0) goto fail;
+
+  while (done < requests) {
+    r = read(fd,in+have,sizeof in-have);
+    if (r < 0 && errno == EINTR) continue;
+    if (r <= 0) goto fail;
+    have += r;
+    t = now();
+    for (j = 0;j+FRAME <= have;j += FRAME) {
+      frame = sent+FRAME*(done%depth);
+      k->latency[done] = t-when[done%depth];
+      if (!check(in+j,frame,x,y)) ++k->errors;
+      ++done;
+    }
+    memmove(in,in+j,have-j);
+    have -= j;
+
+    for (m = 0;next < requests && next < done+depth;++next,++m) {
+      frame = sent+FRAME*(next%depth);
+      request(frame,next,&s);
+      memcpy(out+FRAME*m,frame,FRAME);
+      when[next%depth] = t;
+    }
+    if (m && writeall(fd,out,FRAME*m) < 0) goto fail;
+  }
+  close(fd);
+  mpz_clears(x,y,NULL);
+  return 0;
+
+fail:
+  k->errors += requests-done;
+  close(fd);
+  mpz_clears(x,y,NULL);
+  return 0;
+}
+
+static int cmp(const void *a,const void *b)
+{
+  long long x = *(const long long *) a,y = *(const long long *) b;
+  return (x > y)-(x < y);
+}
+
+static void usage(void)
+{
+  fprintf(stderr,"usage: invload [-s path] [-c connections] [-d depth] [-n requests] [-f function|all] [-v]\n");
+  exit(100);
+}
+
+int main(int argc,char **argv)
+{
+  long long connections = 4,i,total,errors = 0;
+  long long *latency;
+  double seconds;
+  conn *k;
+  int opt;
+
+  while ((opt = getopt(argc,argv,"s:c:d:n:f:v")) != -1)
+    switch (opt) {
+      case 's': path = optarg; break;
+      case 'c': connections = atoll(optarg); break;
+      case 'd': depth = atoll(optarg); break;
+      case 'n': requests = atoll(optarg); break;
+      case 'f':
+        if (!strcmp(optarg,"all")) { function = -1; break; }
+        for (function = 0;function < INVD_FUNCTIONS;++function)
+          if (!strcmp(optarg,functions[function].name)) break;
+        if (function == INVD_FUNCTIONS) usage();
+        break;
+      case 'v': verify = 1; break;
+      default: usage();
+    }
+  if (connections < 1 || depth < 1 || depth > MAXDEPTH || requests < 1) usage();
+  if (!path) path = invd_socket();
+  if (!path) {
+    fprintf(stderr,"invload: no XDG_RUNTIME_DIR for the socket, use -s\n");
+    return 100;
+  }
+  for (i = 0;i < INVD_FUNCTIONS;++i) mpz_init_set_str(moduli[i],functions[i].hex,16);
+
+  total = connections*requests;
+  k = calloc(connections,sizeof *k);
+  latency = calloc(total,sizeof *latency);
+  if (!k || !latency) { perror("invload"); return 111; }
+
+  seconds = now();
+  for (i = 0;i < connections;++i) {
+    k[i].seed = i;
+    k[i].latency = latency+i*requests;
+    if (pthread_create(&k[i].id,0,run,&k[i]) != 0) { perror("invload"); return 111; }
+  }
+  for (i = 0;i < connections;++i) {
+    pthread_join(k[i].id,0);
+    errors += k[i].errors;
+  }
+  seconds = (now()-seconds)*1e-9;
+
+  qsort(latency,total,sizeof *latency,cmp);
+  printf("invload: %lld connections, depth %lld, %lld %s requests in %.2f s: %.0f/s\n",
+    connections,depth,total,function < 0 ? "mixed" : functions[function].name,seconds,total/seconds);
+  printf("latency us p50 %.1f p90 %.1f p99 %.1f max %.1f; %lld errors%s\n",
+    latency[total/2]*1e-3,latency[total*9/10]*1e-3,latency[total*99/100]*1e-3,latency[total-1]*1e-3,
+    errors,verify ? "" : " (unchecked, -v to check)");
+  return errors ? 1 : 0;
+}
@@ -1,8 +1,18 @@
 #ifndef inverse25519_h
 #define inverse25519_h
 
+#include <stdint.h>
+
 #define inverse25519 inverse25519_skylake
+#define inverse25519_fe51 inverse25519_skylake_fe51
+#define inverse25519_fe25 inverse25519_skylake_fe25
 
 void inverse25519(unsigned char *,const unsigned char *);
 
+/* the same on field elements as 5 limbs radix 2^51, each below 2^63,
+   and as 10 int32_t limbs of 26, 25, 26, ... bits, any values; the
+   output is fully reduced */
+void inverse25519_fe51(uint64_t *,const uint64_t *);
+void inverse25519_fe25(int32_t *,const int32_t *);
+
 #endif
@@ -0,0 +1,113 @@
+#include <stdint.h>
+#include "inverse25519.h"
+
+/* inverse25519() on the limb forms of the usual X25519/Ed25519 code:
+   fe51 is 5 unsigned limbs radix 2^51 (donna), fe25 is 10 signed
+   limbs alternately 26 and 25 bits wide (ref10).  The asm reduces any
+   input below 2^256, so the input limbs only need carrying down to a
+   value of that size, not a full reduction; the output is the
+   canonical form, every limb in [0,2^51) or [0,2^26) and [0,2^25). */
+
+static void tolimbs(uint64_t *w,const unsigned char *s)
+{
+  long long i,k;
+
+  for (i = 0;i < 4;++i) {
+    w[i] = 0;
+    for (k = 7;k >= 0;--k) w[i] = (w[i]<<8)|s[8*i+k];
+  }
+}
+
+static void tobytes(unsigned char *s,const uint64_t *w)
+{
+  long long i,k;
+
+  for (i = 0;i < 4;++i)
+    for (k = 0;k < 8;++k)
+      s[8*i+k] = w[i]>>(8*k);
+}
+
+/* any limbs below 2^63 */
+
+void inverse25519_fe51(uint64_t *out,const uint64_t *in)
+{
+  const uint64_t mask = (1ULL<<51)-1;
+  uint64_t h[5],w[4];
+  unsigned char s[32];
+  long long i;
+
+  for (i = 0;i < 5;++i) h[i] = in[i];
+  for (i = 0;i < 4;++i) {
+    h[i+1] += h[i]>>51;
+    h[i] &= mask;
+  }
+  h[0] += 19*(h[4]>>51);
+  h[4] &= mask;
+  for (i = 0;i < 4;++i) {
+    h[i+1] += h[i]>>51;
+    h[i] &= mask;
+  }
+
+  /* h[4] <= 2^51, so the value is below 2^256 */
+  w[0] = h[0]|(h[1]<<51);
+  w[1] = (h[1]>>13)|(h[2]<<38);
+  w[2] = (h[2]>>26)|(h[3]<<25);
+  w[3] = (h[3]>>39)|(h[4]<<12);
+  tobytes(s,w);
+  inverse25519(s,s);
+  tolimbs(w,s);
+
+  out[0] = w[0]&mask;
+  out[1] = ((w[0]>>51)|(w[1]<<13))&mask;
+  out[2] = ((w[1]>>38)|(w[2]<<26))&mask;
+  out[3] = ((w[2]>>25)|(w[3]<<39))&mask;
+  out[4] = w[3]>>12;
+}
+
+/* limb i starts at bit pos[i] and is bits[i] wide */
+
+static const int pos[10] = { 0, 26, 51, 77, 102, 128, 153, 179, 204, 230 } ;
+static const int bits[10] = { 26, 25, 26, 25, 26, 25, 26, 25, 26, 25 } ;
+
+/* any int32_t limbs: 2^7 p is added first, in limbs of 2^7 (2^26-19),
+   2^7 (2^25-1), ..., which are above 2^31, so that every limb is
+   nonnegative and carrying can be unsigned */
+
+void inverse25519_fe25(int32_t *out,const int32_t *in)
+{
+  uint64_t h[10],w[4];
+  unsigned char s[32];
+  long long i,j,k;
+
+  for (i = 0;i < 10;++i) h[i] = (int64_t) in[i]+(((1LL<<bits[i])-1)<<7);
+  h[0] -= 18<<7;
+  for (i = 0;i < 10;++i) {
+    if (i < 9) h[i+1] += h[i]>>bits[i];
+    else h[0] += 19*(h[9]>>25);
+    h[i] &= (1ULL<<bits[i])-1;
+  }
+  for (i = 0;i < 9;++i) {
+    h[i+1] += h[i]>>bits[i];
+    h[i] &= (1ULL<<bits[i])-1;
+  }
+
+  /* h[9] <= 2^25, so the value is below 2^256 */
+  for (i = 0;i < 4;++i) w[i] = 0;
+  for (i = 0;i < 10;++i) {
+    j = pos[i]>>6;
+    k = pos[i]&63;
+    w[j] |= h[i]<<k;
+    if (k+bits[i] > 64) w[j+1] |= h[i]>>(64-k);
+  }
+  tobytes(s,w);
+  inverse25519(s,s);
+  tolimbs(w,s);
+
+  for (i = 0;i < 10;++i) {
+    j = pos[i]>>6;
+    k = pos[i]&63;
+    h[i] = w[j]>>k;
+    if (k+bits[i] > 64) h[i] |= w[j+1]<<(64-k);
+    out[i] = h[i]&((1ULL<<bits[i])-1);
+  }
+}
@@ -2,6 +2,8 @@
 #include <string.h>
 #include <stdio.h>
 #include <assert.h>
+#include <stdlib.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/mman.h>
@@ -160,6 +162,72 @@ void doit(const unsigned char *x)
 long long t[64];
 unsigned char x[32];
 
+/* the limb forms against gmp: fe51 limbs anywhere below 2^63, fe25
+   limbs anywhere in int32_t, both also with small values and with
+   limbs at their bounds */
+
+void checklimbs(void)
+{
+  static const int pos[10] = { 0, 26, 51, 77, 102, 128, 153, 179, 204, 230 } ;
+  uint64_t f[5],g[5];
+  int32_t h[10],k[10];
+  long long i,j;
+
+  for (i = 0;i < 100000;++i) {
+    for (j = 0;j < 5;++j) {
+      f[j] = random()^((uint64_t) random()<<31)^((uint64_t) random()<<62);
+      if (i%4 == 1) f[j] &= (1ULL<<51)-1;
+      if (i%4 == 2) f[j] = ((1ULL<<63)-1)>>(i%13);
+      if (i%4 == 3) f[j] = j ? 0 : i;
+      f[j] &= (1ULL<<63)-1;
+    }
+    mpz_set_ui(x_gmp,0);
+    for (j = 4;j >= 0;--j) {
+      mpz_mul_2exp(x_gmp,x_gmp,51);
+      mpz_set_ui(z_gmp,f[j]>>32);
+      mpz_mul_2exp(z_gmp,z_gmp,32);
+      mpz_add_ui(z_gmp,z_gmp,f[j]&0xffffffff);
+      mpz_add(x_gmp,x_gmp,z_gmp);
+    }
+    if (!mpz_invert(y_gmp,x_gmp,p_gmp)) mpz_set_ui(y_gmp,0);
+    inverse25519_fe51(g,f);
+    mpz_set_ui(z_gmp,0);
+    for (j = 4;j >= 0;--j) {
+      assert(g[j] < (1ULL<<51));
+      mpz_mul_2exp(z_gmp,z_gmp,51);
+      mpz_set_ui(xy_gmp,g[j]>>32);
+      mpz_mul_2exp(xy_gmp,xy_gmp,32);
+      mpz_add_ui(xy_gmp,xy_gmp,g[j]&0xffffffff);
+      mpz_add(z_gmp,z_gmp,xy_gmp);
+    }
+    assert(mpz_cmp(y_gmp,z_gmp) == 0);
+
+    for (j = 0;j < 10;++j) {
+      h[j] = random()^(random()<<16);
+      if (i%4 == 1) h[j] = (h[j]%(1<<25))-(1<<24);
+      if (i%4 == 2) h[j] = (i&8) ? INT32_MIN : INT32_MAX;
+      if (i%4 == 3) h[j] = j ? 0 : i-50000;
+    }
+    mpz_set_ui(x_gmp,0);
+    for (j = 9;j >= 0;--j) {
+      mpz_set_si(z_gmp,h[j]);
+      mpz_mul_2exp(z_gmp,z_gmp,pos[j]);
+      mpz_add(x_gmp,x_gmp,z_gmp);
+    }
+    mpz_mod(x_gmp,x_gmp,p_gmp);
+    if (!mpz_invert(y_gmp,x_gmp,p_gmp)) mpz_set_ui(y_gmp,0);
+    inverse25519_fe25(k,h);
+    mpz_set_ui(z_gmp,0);
+    for (j = 9;j >= 0;--j) {
+      assert(k[j] >= 0 && k[j] < (1<<(j%2 ? 25 : 26)));
+      mpz_set_si(xy_gmp,k[j]);
+      mpz_mul_2exp(xy_gmp,xy_gmp,pos[j]);
+      mpz_add(z_gmp,z_gmp,xy_gmp);
+    }
+    assert(mpz_cmp(y_gmp,z_gmp) == 0);
+  }
+}
+
 void bench(void)
 {
   long long i,j;
@@ -218,6 +286,10 @@ int main()
   gmp_import(two256_gmp,two256,33);
   gmp_import(p_gmp,p,32);
 
+  printf("checking limb forms\n");
+  fflush(stdout);
+  checklimbs();
+
   for (i = -1000;i < 1000;++i) {
     mpz_set_si(x_gmp,i);
     mpz_add(x_gmp,x_gmp,p_gmp);